@@ -13,6 +13,11 @@
     #include <avr/io.h>
 #endif
 
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/eeprom.h>
+#include <util/delay.h>
+
 namespace AVRAssist {
 
     //----------------------------------------------------------------------
@@ -68,7 +73,7 @@ namespace AVRAssist {
         // Prescaler values to get the ADC into the 50-200KHz range.
         //------------------------------------------------------------------
         enum prescaler_t : uint8_t {
-            ADC_PRESCALE_1 = 0,     // Prescaler = divide by 1
+            ADC_PRESCALE_1 = 0,     // Prescaler = divide by 2 (sic), as per the data sheet
             ADC_PRESCALE_2,         // Prescaler = divide by 2
             ADC_PRESCALE_4,         // Prescaler = divide by 4
             ADC_PRESCALE_8,         // Prescaler = divide by 8
@@ -101,10 +106,86 @@ namespace AVRAssist {
         };
 
 
+        //------------------------------------------------------------------
+        // ADC clock cycles taken by a normal conversion. The very first
+        // conversion after enabling the ADC takes 25, auto triggered ones
+        // take 13.5.
+        //------------------------------------------------------------------
+        const uint8_t CONVERSION_CYCLES = 13;
+
+        //------------------------------------------------------------------
+        // The division factor for a prescaler. ADC_PRESCALE_1 actually
+        // divides by 2, the data sheet says so.
+        //------------------------------------------------------------------
+        constexpr uint8_t prescaleDivisor(const prescaler_t prescaler) {
+            return prescaler == ADC_PRESCALE_1 ? 2 : (1 << prescaler);
+        }
+
+        //------------------------------------------------------------------
+        // The fastest ADC clock allowed for a given resolution. The data
+        // sheet wants 50-200KHz for the full 10 bits. For 8 bits, up to
+        // 1MHz is fine.
+        //------------------------------------------------------------------
+        constexpr uint32_t maximumAdcClock(const uint8_t resolution) {
+            return resolution <= 8 ? 1000000UL : 200000UL;
+        }
+
+        //------------------------------------------------------------------
+        // The smallest prescaler that keeps the ADC clock at or below the
+        // maximum for the resolution. Returns ADC_PRESCALE_128 if nothing
+        // fits, so check the result.
+        //------------------------------------------------------------------
+        constexpr prescaler_t fastestPrescaler(const uint32_t cpuFrequency,
+                                               const uint8_t resolution,
+                                               const uint8_t prescaler = ADC_PRESCALE_2) {
+            return (prescaler >= ADC_PRESCALE_128 ||
+                    cpuFrequency / prescaleDivisor(prescaler_t(prescaler)) <= maximumAdcClock(resolution))
+                   ? prescaler_t(prescaler)
+                   : fastestPrescaler(cpuFrequency, resolution, prescaler + 1);
+        }
+
+        //------------------------------------------------------------------
+        // Compile time prescaler solver. Given F_CPU, the resolution (8 or
+        // 10 bits) and the required conversions per second, this gives the
+        // fastest legal prescaler and the conversions per second it will
+        // actually achieve. It refuses to compile if the rate can't be met.
+        //
+        // Usage:
+        //
+        // typedef Adc::PrescalerFor<F_CPU, 10, 9600> Solved;
+        // Adc::initialise(Adc::REFV_AVCC, Adc::SAMPLE_ADC0,
+        //                 Adc::INT_ENABLED, Adc::ALIGN_RIGHT,
+        //                 Solved::prescaler);
+        //------------------------------------------------------------------
+        template <uint32_t cpuFrequency, uint8_t resolution, uint32_t sampleRate>
+        struct PrescalerFor {
+            static_assert(resolution == 8 || resolution == 10,
+                          "ADC resolution must be 8 or 10 bits.");
+
+            static constexpr prescaler_t prescaler = fastestPrescaler(cpuFrequency, resolution);
+            static constexpr uint32_t adcClock = cpuFrequency / prescaleDivisor(prescaler);
+            static constexpr uint32_t conversionsPerSecond = adcClock / CONVERSION_CYCLES;
+
+            static_assert(adcClock <= maximumAdcClock(resolution),
+                          "F_CPU is too fast for any ADC prescaler at this resolution.");
+            static_assert(conversionsPerSecond >= sampleRate,
+                          "The ADC cannot convert this quickly at this resolution.");
+        };
+
+        template <uint32_t cpuFrequency, uint8_t resolution, uint32_t sampleRate>
+        constexpr prescaler_t PrescalerFor<cpuFrequency, resolution, sampleRate>::prescaler;
+
+        template <uint32_t cpuFrequency, uint8_t resolution, uint32_t sampleRate>
+        constexpr uint32_t PrescalerFor<cpuFrequency, resolution, sampleRate>::adcClock;
+
+        template <uint32_t cpuFrequency, uint8_t resolution, uint32_t sampleRate>
+        constexpr uint32_t PrescalerFor<cpuFrequency, resolution, sampleRate>::conversionsPerSecond;
+
+
         //------------------------------------------------------------------
         // Initialise the ADC.
         //------------------------------------------------------------------
-        void initialise(const reference_t referenceSource,
+        inline void initialise(const reference_t referenceSource,
                         const sample_t sampleSource,
                         const interrupt_t interruptMode = INT_DISABLED,
                         const alignment_t alignment = ALIGN_RIGHT,
@@ -176,10 +257,753 @@ namespace AVRAssist {
         // ADC is enabled, execute a start conversion on demand. This is
         // require if using AUTO_DISABLED or AUTO_FREE_RUNNING.
         //--------------------------------------------------------------
-        void start() {
+        inline void start() {
+            ADCSRA |= (1 << ADSC);
+        }
+
+
+        //--------------------------------------------------------------
+        // Change channel without re-initialising. Only the MUX bits in
+        // ADMUX are touched, the reference, alignment, prescaler and
+        // trigger settings are all kept. With a constant channel, this
+        // is four instructions.
+        //--------------------------------------------------------------
+        inline void select(const sample_t sampleSource) {
+            ADMUX = (ADMUX & 0xF0) | sampleSource;
+        }
+
+        //--------------------------------------------------------------
+        // Change channel, start a conversion and wait for the result.
+        // Only the MUX bits and ADSC are touched. The ADC must already
+        // have been initialised, and not be running auto-triggered.
+        //--------------------------------------------------------------
+        inline uint16_t read(const sample_t sampleSource) {
+            select(sampleSource);
             ADCSRA |= (1 << ADSC);
+
+            while (ADCSRA & (1 << ADSC)) {
+                ;
+            }
+
+            return ADCW;
+        }
+
+
+        //------------------------------------------------------------------
+        // Initialise for fast 8 bit results. The result is left aligned,
+        // so that ADCH holds the top 8 bits, and the prescaler is the
+        // fastest that keeps the ADC clock at or below 1MHz for F_CPU.
+        // The remaining parameters are as for initialise().
+        //------------------------------------------------------------------
+        inline void initialise8Bit(const reference_t referenceSource,
+                                   const sample_t sampleSource,
+                                   const interrupt_t interruptMode = INT_DISABLED,
+                                   const autotrigger_t autoTriggerMode = AUTO_DISABLED,
+                                   const autosource_t autoTriggerSource = AUTO_FREE_RUNNING) {
+            initialise(referenceSource,
+                       sampleSource,
+                       interruptMode,
+                       ALIGN_LEFT,
+                       PrescalerFor<F_CPU, 8, 1>::prescaler,
+                       autoTriggerMode,
+                       autoTriggerSource);
+        }
+
+        //------------------------------------------------------------------
+        // Read an 8 bit result. Only ADCH is read, which is all that's
+        // needed when left aligned.
+        //------------------------------------------------------------------
+        inline uint8_t result8() {
+            return ADCH;
+        }
+
+        //------------------------------------------------------------------
+        // Call from ISR(ADC_vect) to push an 8 bit result straight into a
+        // byte sized buffer, a RingBuffer<uint8_t, n> for example. Returns
+        // whatever the buffer's push() returns.
+        //------------------------------------------------------------------
+        template <typename buffer_t>
+        inline bool capture8(buffer_t &buffer) {
+            return buffer.push(ADCH);
+        }
+
+
+        //------------------------------------------------------------------
+        // Take a single conversion, of whatever ADMUX currently selects,
+        // with the CPU halted in ADC Noise Reduction sleep mode. Entering
+        // the sleep mode starts the conversion, and the ADC interrupt wakes
+        // the CPU when it completes.
+        //
+        // Your code must have an ISR(ADC_vect), even if it's empty, but
+        // doesn't need to have initialised with INT_ENABLED as ADIE is
+        // enabled here. Global interrupts are enabled while asleep, then
+        // put back as they were. Any auto-triggering is suspended for the
+        // conversion. After that, free running mode will need restarting
+        // with start().
+        //------------------------------------------------------------------
+        inline uint16_t readInNoiseReductionSleep() {
+            //--------------------------------------------------------------
+            // Stop auto-triggering first. In free running mode ADSC never
+            // clears, so waiting for it with ADATE still set would hang.
+            // Then let any conversion in progress finish.
+            //--------------------------------------------------------------
+            uint8_t oldADCSRA = ADCSRA;
+            ADCSRA = oldADCSRA & ~((1 << ADATE) | (1 << ADIF));
+
+            while (ADCSRA & (1 << ADSC)) {
+                ;
+            }
+
+            // Single conversion, with the interrupt enabled to wake us up
+            // and any stale interrupt flag cleared. ADSC stays clear, even
+            // if it was set for free running, or the conversion would start
+            // now, with the CPU still awake.
+            ADCSRA = (oldADCSRA & ~((1 << ADATE) | (1 << ADSC))) | (1 << ADEN) | (1 << ADIE) | (1 << ADIF);
+
+            uint8_t oldSREG = SREG;
+            set_sleep_mode(SLEEP_MODE_ADC);
+            sleep_enable();
+
+            // Go to sleep, which starts the conversion.
+            sei();
+            sleep_cpu();
+
+            //--------------------------------------------------------------
+            // Some other interrupt may have woken us early. If so, go back
+            // to sleep. Checking with interrupts off, then doing the sei()
+            // and sleep together, means that we can't miss the wake up.
+            //--------------------------------------------------------------
+            while (true) {
+                cli();
+                if (!(ADCSRA & (1 << ADSC))) {
+                    break;
+                }
+
+                sei();
+                sleep_cpu();
+            }
+
+            sleep_disable();
+            uint16_t result = ADCW;
+
+            // Put things back as they were, apart from ADSC. Any other
+            // trigger carries on by itself, but free running doesn't start
+            // again until start() sets ADSC.
+            ADCSRA = oldADCSRA & ~((1 << ADSC) | (1 << ADIF));
+            SREG = oldSREG;
+            return result;
+        }
+
+
+        //------------------------------------------------------------------
+        // Returned from Scanner::handleInterrupt() when the conversion just
+        // completed was thrown away after a change of channel.
+        //------------------------------------------------------------------
+        const uint8_t SCAN_DISCARDED = 0xFF;
+
+        //------------------------------------------------------------------
+        // Compile time helpers for the Scanner. Only ADC0-ADC7, BANDGAP
+        // and GND can be scanned. ADC8 needs the bandgap reference and
+        // cannot be auto-triggered, so it can't be mixed in with the rest.
+        //------------------------------------------------------------------
+        constexpr bool scannable() {
+            return true;
+        }
+
+        template <typename... others>
+        constexpr bool scannable(const sample_t channel, const others... rest) {
+            return (channel <= SAMPLE_ADC7 ||
+                    channel == SAMPLE_BANDGAP ||
+                    channel == SAMPLE_GND) && scannable(rest...);
+        }
+
+        constexpr uint8_t digitalInputs() {
+            return 0;
         }
 
+        template <typename... others>
+        constexpr uint8_t digitalInputs(const sample_t channel, const others... rest) {
+            return (channel <= SAMPLE_ADC5 ? (1 << channel) : 0) | digitalInputs(rest...);
+        }
+
+
+        //------------------------------------------------------------------
+        // Interrupt driven multi-channel scanner. The ADC is initialised
+        // once, in free running mode, and the ISR rotates the MUX bits in
+        // ADMUX to the next channel on every conversion. Call
+        // handleInterrupt() from your ISR(ADC_vect).
+        //
+        // In free running mode the next conversion has already started by
+        // the time the interrupt fires, so a change to ADMUX only applies
+        // to the conversion after that one. The first result after each
+        // channel change is therefore discarded.
+        //
+        // Usage:
+        //
+        // typedef Adc::Scanner<Adc::SAMPLE_ADC0, Adc::SAMPLE_ADC3> Scan;
+        // ISR(ADC_vect) { Scan::handleInterrupt(); }
+        // ...
+        // Scan::initialise(Adc::REFV_AVCC);
+        // ...
+        // uint16_t a3 = Scan::read(1);
+        //------------------------------------------------------------------
+        template <sample_t... channels>
+        class Scanner {
+            static_assert(sizeof...(channels) > 0,
+                          "Scanner needs at least one channel.");
+            static_assert(sizeof...(channels) < SCAN_DISCARDED,
+                          "Scanner has too many channels.");
+            static_assert(scannable(channels...),
+                          "Scanner channels must be ADC0-ADC7, BANDGAP or GND.");
+
+        public:
+            static const uint8_t channelCount = sizeof...(channels);
+
+            // The latest result for each channel, in the order given.
+            static volatile uint16_t results[sizeof...(channels)];
+
+            // Incremented every time all channels have been read.
+            static volatile uint8_t sweeps;
+
+            //--------------------------------------------------------------
+            // Set the ADC up to scan the channels, and start it running.
+            // Global interrupts must be enabled by your code.
+            //--------------------------------------------------------------
+            static void initialise(const reference_t referenceSource,
+                                   const prescaler_t prescaler = ADC_PRESCALE_128) {
+                current = 0;
+                discard = true;     // First conversion is an extended one.
+                sweeps = 0;
+
+                Adc::initialise(referenceSource,
+                                channelList[0],
+                                INT_ENABLED,
+                                ALIGN_RIGHT,
+                                prescaler,
+                                AUTO_ENABLED,
+                                AUTO_FREE_RUNNING);
+
+                // Power off the digital input buffers for every channel.
+                DIDR0 |= digitalInputs(channels...);
+
+                start();
+            }
+
+            //--------------------------------------------------------------
+            // Call this from ISR(ADC_vect). Returns the index of the
+            // channel whose result was just stored, or SCAN_DISCARDED.
+            //--------------------------------------------------------------
+            static uint8_t handleInterrupt() {
+                uint16_t reading = ADCW;
+
+                if (discard) {
+                    discard = false;
+                    return SCAN_DISCARDED;
+                }
+
+                uint8_t stored = current;
+                results[stored] = reading;
+
+                if (++current == channelCount) {
+                    current = 0;
+                    sweeps++;
+                }
+
+                // Nothing to change with only the one channel.
+                if (channelCount > 1) {
+                    select(channelList[current]);
+                    discard = true;
+                }
+
+                return stored;
+            }
+
+            //--------------------------------------------------------------
+            // Read the latest result for a channel, by index, from outside
+            // of the ISR. The 16 bit read is protected from the ISR.
+            //--------------------------------------------------------------
+            static uint16_t read(const uint8_t index) {
+                uint8_t oldSREG = SREG;
+                cli();
+                uint16_t result = results[index];
+                SREG = oldSREG;
+                return result;
+            }
+
+        private:
+            static const sample_t channelList[sizeof...(channels)];
+            static uint8_t current;
+            static bool discard;
+        };
+
+        template <sample_t... channels>
+        volatile uint16_t Scanner<channels...>::results[sizeof...(channels)];
+
+        template <sample_t... channels>
+        volatile uint8_t Scanner<channels...>::sweeps;
+
+        template <sample_t... channels>
+        const sample_t Scanner<channels...>::channelList[sizeof...(channels)] = { channels... };
+
+        template <sample_t... channels>
+        uint8_t Scanner<channels...>::current;
+
+        template <sample_t... channels>
+        bool Scanner<channels...>::discard;
+
+        //------------------------------------------------------------------
+        // Oversampling and decimation, for 11 to 14 bit results. For each
+        // extra bit, n, 4^n conversions are summed and the total shifted
+        // right by n bits. Call handleInterrupt() from ISR(ADC_vect), it
+        // only adds, there's no division in the ISR. The main loop only
+        // sees finished results.
+        //
+        // This only works if there's at least 1 LSB of noise on the input
+        // signal, see Atmel application note AVR121.
+        //
+        // Usage:
+        //
+        // typedef Adc::Oversampler<12> Over;
+        // ISR(ADC_vect) { Over::handleInterrupt(); }
+        // ...
+        // if (Over::available()) { uint16_t twelveBits = Over::read(); }
+        //------------------------------------------------------------------
+        template <uint8_t resolution>
+        class Oversampler {
+            static_assert(resolution >= 11 && resolution <= 14,
+                          "Oversampler resolution must be 11 to 14 bits.");
+
+        public:
+            static const uint8_t extraBits = resolution - 10;
+            static const uint16_t samples = 1U << (2 * extraBits);
+
+            //--------------------------------------------------------------
+            // Call this from ISR(ADC_vect). Returns true when a new result
+            // has just been finished.
+            //--------------------------------------------------------------
+            static bool handleInterrupt() {
+                accumulator += ADCW;
+
+                if (--remaining) {
+                    return false;
+                }
+
+                result = accumulator >> extraBits;
+                accumulator = 0;
+                remaining = samples;
+                ready = true;
+                return true;
+            }
+
+            //--------------------------------------------------------------
+            // Is there a finished result that hasn't been read yet?
+            //--------------------------------------------------------------
+            static bool available() {
+                return ready;
+            }
+
+            //--------------------------------------------------------------
+            // Read the latest finished result, from outside of the ISR.
+            //--------------------------------------------------------------
+            static uint16_t read() {
+                uint8_t oldSREG = SREG;
+                cli();
+                uint16_t latest = result;
+                ready = false;
+                SREG = oldSREG;
+                return latest;
+            }
+
+            //--------------------------------------------------------------
+            // Throw away any partial sum, after a channel change perhaps.
+            //--------------------------------------------------------------
+            static void reset() {
+                uint8_t oldSREG = SREG;
+                cli();
+                accumulator = 0;
+                remaining = samples;
+                ready = false;
+                SREG = oldSREG;
+            }
+
+        private:
+            static uint32_t accumulator;
+            static uint16_t remaining;
+            static volatile uint16_t result;
+            static volatile bool ready;
+        };
+
+        template <uint8_t resolution>
+        uint32_t Oversampler<resolution>::accumulator;
+
+        template <uint8_t resolution>
+        uint16_t Oversampler<resolution>::remaining = Oversampler<resolution>::samples;
+
+        template <uint8_t resolution>
+        volatile uint16_t Oversampler<resolution>::result;
+
+        template <uint8_t resolution>
+        volatile bool Oversampler<resolution>::ready;
+
+
+        //------------------------------------------------------------------
+        // Calibration constants for readVcc() and readTemperature(). These
+        // can be kept in EEPROM, see loadCalibration(). The defaults are
+        // the typical values from the data sheet.
+        //------------------------------------------------------------------
+        struct calibration_t {
+            uint16_t bandgapMillivolts;     // Actual bandgap voltage, in mV.
+            uint16_t temperatureAt25C;      // ADC8 result at 25 Celsius.
+            uint16_t degreesPerLsb;         // Celsius per ADC8 LSB, x 256.
+        };
+
+        const calibration_t DEFAULT_CALIBRATION = { 1100, 292, 275 };
+
+        //------------------------------------------------------------------
+        // The calibration in use, and the cached Vcc and temperature
+        // readings.
+        //------------------------------------------------------------------
+        inline calibration_t &calibration() {
+            static calibration_t values = DEFAULT_CALIBRATION;
+            return values;
+        }
+
+        struct cachedReading_t {
+            uint32_t takenAt;
+            uint16_t value;
+            bool valid;
+        };
+
+        inline cachedReading_t &cachedVcc() {
+            static cachedReading_t reading;
+            return reading;
+        }
+
+        inline cachedReading_t &cachedTemperature() {
+            static cachedReading_t reading;
+            return reading;
+        }
+
+        //------------------------------------------------------------------
+        // Load the calibration from EEPROM. If the EEPROM is blank, the
+        // defaults are used. Any cached readings are thrown away.
+        //------------------------------------------------------------------
+        inline void loadCalibration(const calibration_t *eepromAddress) {
+            calibration_t values;
+            eeprom_read_block(&values, eepromAddress, sizeof(values));
+
+            if (values.bandgapMillivolts == 0xFFFF) {
+                values = DEFAULT_CALIBRATION;
+            }
+
+            calibration() = values;
+            cachedVcc().valid = false;
+            cachedTemperature().valid = false;
+        }
+
+        //------------------------------------------------------------------
+        // Save calibration to EEPROM, and start using it. Only changed
+        // bytes are written.
+        //------------------------------------------------------------------
+        inline void saveCalibration(const calibration_t &values,
+                                    calibration_t *eepromAddress) {
+            eeprom_update_block(&values, eepromAddress, sizeof(values));
+            calibration() = values;
+            cachedVcc().valid = false;
+            cachedTemperature().valid = false;
+        }
+
+        //------------------------------------------------------------------
+        // Time allowed for the capacitor on AREF to charge, or discharge,
+        // after the reference is changed, or the ADC was off. It drifts
+        // by less than 1 LSB per conversion for much of that time, so
+        // agreement between readings alone can't be trusted until then.
+        //------------------------------------------------------------------
+        const uint8_t REFERENCE_SETTLE_MS = 5;
+
+        //------------------------------------------------------------------
+        // Take a settled, polled, reading with the given ADMUX setting,
+        // then put the ADC back the way it was. If the reference changed,
+        // wait REFERENCE_SETTLE_MS first. Then, after throwing away the
+        // first conversion, conversions are repeated until two in a row
+        // agree to within 1 LSB.
+        //------------------------------------------------------------------
+        inline uint16_t settledReading(const uint8_t muxSetting) {
+            //--------------------------------------------------------------
+            // Stop auto-triggering first. In free running mode ADSC never
+            // clears, so waiting for it with ADATE still set would hang.
+            // Then let any conversion in progress finish.
+            //--------------------------------------------------------------
+            uint8_t oldADMUX = ADMUX;
+            uint8_t oldADCSRA = ADCSRA;
+            ADCSRA = oldADCSRA & ~((1 << ADATE) | (1 << ADIF));
+
+            while (ADCSRA & (1 << ADSC)) {
+                ;
+            }
+
+            const uint8_t referenceBits = (1 << REFS1) | (1 << REFS0);
+            bool referenceChanged = !(oldADCSRA & (1 << ADEN)) ||
+                                    ((oldADMUX ^ muxSetting) & referenceBits);
+            uint8_t prescaler = (oldADCSRA & (1 << ADEN))
+                                ? (oldADCSRA & ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0)))
+                                : uint8_t(PrescalerFor<F_CPU, 10, 1>::prescaler);
+
+            // Single conversions, polled, with no interrupts.
+            PRR &= ~(1 << PRADC);
+            ADMUX = muxSetting;
+            ADCSRA = (1 << ADEN) | (1 << ADIF) | prescaler;
+
+            if (referenceChanged) {
+                _delay_ms(REFERENCE_SETTLE_MS);
+            }
+
+            // The first conversion after a change of channel is thrown
+            // away, so it can't be one half of an agreeing pair.
+            uint16_t previous = 0xFFFF;
+            uint16_t reading = 0;
+
+            ADCSRA |= (1 << ADSC);
+            while (ADCSRA & (1 << ADSC)) {
+                ;
+            }
+
+            for (uint8_t attempt = 0; attempt < 64; attempt++) {
+                ADCSRA |= (1 << ADSC);
+                while (ADCSRA & (1 << ADSC)) {
+                    ;
+                }
+
+                reading = ADCW;
+                if (reading + 1 >= previous && reading <= previous + 1) {
+                    break;
+                }
+
+                previous = reading;
+            }
+
+            // Put things back, restarting free running mode if need be.
+            ADMUX = oldADMUX;
+            ADCSRA = (oldADCSRA & ~(1 << ADSC)) | (1 << ADIF);
+
+            if ((oldADCSRA & (1 << ADATE)) &&
+                (ADCSRB & ((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))) == AUTO_FREE_RUNNING) {
+                start();
+            }
+
+            return reading;
+        }
+
+        //------------------------------------------------------------------
+        // Supply voltage, AVCC, in millivolts. This is measured by reading
+        // the bandgap against AVCC. 'now' is the current time in whatever
+        // units you like, millis() perhaps. A cached value is returned if
+        // the last reading was taken less than 'refreshInterval' ago. Use
+        // a refresh interval of zero to always take a new reading.
+        //------------------------------------------------------------------
+        inline uint16_t readVcc(const uint32_t now = 0,
+                                const uint32_t refreshInterval = 0) {
+            cachedReading_t &cache = cachedVcc();
+
+            if (cache.valid && now - cache.takenAt < refreshInterval) {
+                return cache.value;
+            }
+
+            uint16_t reading = settledReading(REFV_AVCC | SAMPLE_BANDGAP);
+
+            cache.value = (uint32_t(calibration().bandgapMillivolts) * 1024) / (reading ? reading : 1);
+            cache.takenAt = now;
+            cache.valid = true;
+            return cache.value;
+        }
+
+        //------------------------------------------------------------------
+        // On die temperature, in whole degrees Celsius, from the ADC8
+        // sensor against the bandgap reference. Caching is the same as for
+        // readVcc(). The default calibration is only good to around +/-10
+        // degrees, each device should really be calibrated.
+        //------------------------------------------------------------------
+        inline int16_t readTemperature(const uint32_t now = 0,
+                                       const uint32_t refreshInterval = 0) {
+            cachedReading_t &cache = cachedTemperature();
+
+            if (cache.valid && now - cache.takenAt < refreshInterval) {
+                return int16_t(cache.value);
+            }
+
+            int32_t reading = settledReading(REFV_BANDGAP | SAMPLE_ADC8);
+            int32_t offset = reading - calibration().temperatureAt25C;
+            int16_t celsius = 25 + (offset * calibration().degreesPerLsb) / 256;
+
+            cache.value = uint16_t(celsius);
+            cache.takenAt = now;
+            cache.valid = true;
+            return celsius;
+        }
+
+
+        //------------------------------------------------------------------
+        // Where a value is, relative to a window monitor's thresholds.
+        //------------------------------------------------------------------
+        enum zone_t : uint8_t {
+            ZONE_UNKNOWN = 0,       // No value checked yet.
+            ZONE_BELOW,             // Below the low threshold.
+            ZONE_INSIDE,            // Between the thresholds.
+            ZONE_ABOVE              // Above the high threshold.
+        };
+
+        //------------------------------------------------------------------
+        // Called, from the ISR, when a channel moves into a new zone.
+        //------------------------------------------------------------------
+        typedef void (*windowCallback_t)(const uint8_t channel,
+                                         const zone_t zone,
+                                         const uint16_t value);
+
+        //------------------------------------------------------------------
+        // Software window comparator, for up to 8 channels. Call check()
+        // from ISR(ADC_vect) with each new result. Nothing happens unless
+        // a channel moves into a different zone, when the callback, if
+        // any, is called and the channel's bit is set in events().
+        //
+        // To leave a zone, a value has to get back past the threshold by
+        // more than the hysteresis, which stops a noisy value sitting on a
+        // threshold from raising event after event.
+        //
+        // Usage, free running on a single channel:
+        //
+        // typedef Adc::WindowMonitor<1> Window;
+        // ISR(ADC_vect) { Window::check(0, ADCW); }
+        //
+        // or with a Scanner:
+        //
+        // ISR(ADC_vect) {
+        //     uint8_t channel = Scan::handleInterrupt();
+        //     if (channel != Adc::SCAN_DISCARDED) {
+        //         Window::check(channel, Scan::results[channel]);
+        //     }
+        // }
+        //------------------------------------------------------------------
+        template <uint8_t channelCount>
+        class WindowMonitor {
+            static_assert(channelCount >= 1 && channelCount <= 8,
+                          "WindowMonitor handles 1 to 8 channels.");
+
+        public:
+            //--------------------------------------------------------------
+            // Set the window for a channel. The channel's zone is reset,
+            // so the next check() will raise an event.
+            //--------------------------------------------------------------
+            static void setWindow(const uint8_t channel,
+                                  const uint16_t lowThreshold,
+                                  const uint16_t highThreshold,
+                                  const uint16_t hysteresis = 0) {
+                uint8_t oldSREG = SREG;
+                cli();
+                low[channel] = lowThreshold;
+                high[channel] = highThreshold;
+                margin[channel] = hysteresis;
+                zones[channel] = ZONE_UNKNOWN;
+                SREG = oldSREG;
+            }
+
+            //--------------------------------------------------------------
+            // Set the function to be called, from the ISR, on each event.
+            // Keep it short!
+            //--------------------------------------------------------------
+            static void setCallback(const windowCallback_t function) {
+                uint8_t oldSREG = SREG;
+                cli();
+                callback = function;
+                SREG = oldSREG;
+            }
+
+            //--------------------------------------------------------------
+            // Call this from ISR(ADC_vect). Returns true if the channel has
+            // moved into a different zone.
+            //--------------------------------------------------------------
+            static bool check(const uint8_t channel, const uint16_t value) {
+                zone_t current = zones[channel];
+                zone_t next = current;
+
+                // Leaving a zone needs the hysteresis to be overcome.
+                uint16_t lowEdge = low[channel];
+                uint16_t highEdge = high[channel];
+
+                if (current == ZONE_BELOW) {
+                    lowEdge += margin[channel];
+                } else if (current == ZONE_ABOVE) {
+                    highEdge -= margin[channel];
+                }
+
+                if (value < lowEdge) {
+                    next = ZONE_BELOW;
+                } else if (value > highEdge) {
+                    next = ZONE_ABOVE;
+                } else {
+                    next = ZONE_INSIDE;
+                }
+
+                if (next == current) {
+                    return false;
+                }
+
+                zones[channel] = next;
+                pending |= (1 << channel);
+
+                if (callback) {
+                    callback(channel, next, value);
+                }
+
+                return true;
+            }
+
+            //--------------------------------------------------------------
+            // Which channels have had events since the last call? One bit
+            // per channel, bit 0 for channel 0. The bits are cleared.
+            //--------------------------------------------------------------
+            static uint8_t events() {
+                uint8_t oldSREG = SREG;
+                cli();
+                uint8_t channels = pending;
+                pending = 0;
+                SREG = oldSREG;
+                return channels;
+            }
+
+            //--------------------------------------------------------------
+            // The zone a channel is currently in.
+            //--------------------------------------------------------------
+            static zone_t zone(const uint8_t channel) {
+                return zones[channel];
+            }
+
+        private:
+            static uint16_t low[channelCount];
+            static uint16_t high[channelCount];
+            static uint16_t margin[channelCount];
+            static volatile zone_t zones[channelCount];
+            static volatile uint8_t pending;
+            static windowCallback_t callback;
+        };
+
+        template <uint8_t channelCount>
+        uint16_t WindowMonitor<channelCount>::low[channelCount];
+
+        template <uint8_t channelCount>
+        uint16_t WindowMonitor<channelCount>::high[channelCount];
+
+        template <uint8_t channelCount>
+        uint16_t WindowMonitor<channelCount>::margin[channelCount];
+
+        template <uint8_t channelCount>
+        volatile zone_t WindowMonitor<channelCount>::zones[channelCount];
+
+        template <uint8_t channelCount>
+        volatile uint8_t WindowMonitor<channelCount>::pending;
+
+        template <uint8_t channelCount>
+        windowCallback_t WindowMonitor<channelCount>::callback;
+
     } // End of Adc namespace.
 
 }  // End of AVRAssist namespace.
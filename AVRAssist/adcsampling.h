@@ -0,0 +1,127 @@
+#ifndef __ADCSAMPLING_H__
+#define __ADCSAMPLING_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include "adc.h"
+#include "timer1.h"
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Fixed rate ADC sampling, with each conversion triggered by Timer 1
+    // compare match B. Including adc.h alone doesn't bring in Timer 1.
+    //----------------------------------------------------------------------
+    namespace Adc {
+
+        //------------------------------------------------------------------
+        // CPU clock cycles between samples.
+        //------------------------------------------------------------------
+        constexpr uint32_t samplingTicks(const uint32_t cpuFrequency,
+                                         const uint32_t sampleRate,
+                                         const uint8_t clockSource) {
+            return (cpuFrequency + (uint32_t(Timer1::prescaleDivisor(clockSource)) * sampleRate) / 2) /
+                   (uint32_t(Timer1::prescaleDivisor(clockSource)) * sampleRate);
+        }
+
+        //------------------------------------------------------------------
+        // The smallest Timer 1 prescaler that gets the sample period into
+        // 16 bits. The smaller the prescaler, the closer the actual rate
+        // is to the requested one.
+        //------------------------------------------------------------------
+        constexpr uint8_t samplingClock(const uint32_t cpuFrequency,
+                                        const uint32_t sampleRate,
+                                        const uint8_t clockSource = Timer1::CLK_PRESCALE_1) {
+            return (clockSource >= Timer1::CLK_PRESCALE_1024 ||
+                    samplingTicks(cpuFrequency, sampleRate, clockSource) <= 65536UL)
+                   ? clockSource
+                   : samplingClock(cpuFrequency, sampleRate, clockSource + 1);
+        }
+
+        //------------------------------------------------------------------
+        // Start sampling at a fixed rate, in Hz. Timer 1 is put into CTC
+        // mode, with TOP = OCR1A, and OCR1B = OCR1A so that compare match
+        // B happens once per period. The ADC is auto-triggered from
+        // compare match B, with the fastest prescaler that allows 10 bit
+        // results at this rate.
+        //
+        // The ADC only triggers on a rising edge of the OCF1B flag, so the
+        // flag must be cleared after each conversion. The ADC interrupt is
+        // always enabled, and your ISR(ADC_vect) MUST call sampledResult(),
+        // which clears the flag and reads the result in one go. If it
+        // doesn't, sampling stops after the first conversion.
+        //
+        // This takes over Timer 1 completely.
+        //------------------------------------------------------------------
+        template <uint32_t sampleRate>
+        void startSampling(const reference_t referenceSource,
+                           const sample_t sampleSource,
+                           const alignment_t alignment = ALIGN_RIGHT) {
+
+            typedef PrescalerFor<F_CPU, 10, sampleRate> adcClock;
+
+            static const uint8_t clockSource = samplingClock(F_CPU, sampleRate);
+            static const uint32_t ticks = samplingTicks(F_CPU, sampleRate, clockSource);
+
+            static_assert(sampleRate > 0, "Sample rate must be above zero.");
+            static_assert(ticks >= 2 && ticks <= 65536UL,
+                          "Sample rate cannot be generated by Timer 1.");
+
+            // Auto-triggered conversions take 13.5 ADC clock cycles.
+            static_assert(adcClock::adcClock * 2 / 27 >= sampleRate,
+                          "The ADC cannot keep up with this sample rate.");
+
+            //--------------------------------------------------------------
+            // Timer 1 first, with the clock stopped. OCR1A/B must be
+            // written after Timer1::initialise(), see Foibles.
+            //--------------------------------------------------------------
+            Timer1::initialise(Timer1::MODE_CTC_OCR1A, Timer1::CLK_DISABLED);
+            TCNT1 = 0;
+            OCR1A = ticks - 1;
+            OCR1B = ticks - 1;
+            TIFR1 = (1 << OCF1B);
+
+            Adc::initialise(referenceSource,
+                            sampleSource,
+                            INT_ENABLED,
+                            alignment,
+                            adcClock::prescaler,
+                            AUTO_ENABLED,
+                            AUTO_TIMER1_MATCH_B);
+
+            // And go.
+            TCCR1B |= clockSource;
+        }
+
+        //------------------------------------------------------------------
+        // Call from ISR(ADC_vect) when sampling. Clears OCF1B, to re-arm
+        // the trigger, and returns the result.
+        //------------------------------------------------------------------
+        inline uint16_t sampledResult() {
+            TIFR1 = (1 << OCF1B);
+            return ADCW;
+        }
+
+        //------------------------------------------------------------------
+        // Stop sampling. Timer 1 is stopped and auto-triggering disabled,
+        // the ADC itself is left enabled.
+        //------------------------------------------------------------------
+        inline void stopSampling() {
+            TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
+            ADCSRA &= ~(1 << ADATE);
+        }
+
+    } // End of Adc namespace.
+
+}  // End of AVRAssist namespace.
+#endif // __ADCSAMPLING_H__
@@ -0,0 +1,208 @@
+#ifndef __ADCSTREAM_H__
+#define __ADCSTREAM_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include "adc.h"
+#include "usart.h"
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Streaming blocks of ADC results out of the USART, in binary frames.
+    // Kept apart from adc.h, so the ADC can be used without the USART.
+    //----------------------------------------------------------------------
+    namespace Adc {
+
+        //------------------------------------------------------------------
+        // Frame layout, all multi-byte values are little endian:
+        //
+        // +--------+--------+----------+-------+----------------+----------+
+        // | 0xA5   | 0x5A   | Sequence | Count | Count samples  | Checksum |
+        // | 1 byte | 1 byte | 1 byte   | 1     | 2 bytes each   | 2 bytes  |
+        // +--------+--------+----------+-------+----------------+----------+
+        //
+        // The checksum is the sequence number plus all the samples, as a
+        // 16 bit sum. The sequence number goes up by one for every block
+        // filled, so a gap means a block was dropped.
+        //------------------------------------------------------------------
+        const uint8_t STREAM_SYNC_1 = 0xA5;
+        const uint8_t STREAM_SYNC_2 = 0x5A;
+
+        //------------------------------------------------------------------
+        // Ping-pong block streaming. ADC_vect fills one block while the
+        // USART data register empty interrupt sends the other, straight
+        // out of the block, with no copying. Call handleSample() from
+        // ISR(ADC_vect) and handleTransmit() from ISR(USART_UDRE_vect).
+        //
+        // If a block fills up while the previous one is still being sent,
+        // the new one is dropped, counted in 'dropped', and refilled. The
+        // baud rate must keep up with 2 bytes per sample, plus 6 bytes per
+        // block, to avoid this.
+        //------------------------------------------------------------------
+        template <uint8_t blockSize>
+        class Streamer {
+            static_assert(blockSize > 0 && blockSize <= 127,
+                          "Streamer block size must be 1 to 127 samples.");
+
+        public:
+            // Blocks dropped because the USART wasn't keeping up.
+            static volatile uint8_t dropped;
+
+            //--------------------------------------------------------------
+            // Reset the streamer. Call this before starting the ADC, and
+            // after initialising the USART with Usart::initialise().
+            //--------------------------------------------------------------
+            static void initialise() {
+                uint8_t oldSREG = SREG;
+                cli();
+                filling = 0;
+                fillCount = 0;
+                sums[0] = 0;
+                sending = NOT_SENDING;
+                sequence = 0;
+                dropped = 0;
+                Usart::disableDataEmptyInterrupt();
+                SREG = oldSREG;
+            }
+
+            //--------------------------------------------------------------
+            // Call this from ISR(ADC_vect).
+            //--------------------------------------------------------------
+            static void handleSample() {
+                uint16_t sample = ADCW;
+
+                blocks[filling][fillCount] = sample;
+                sums[filling] += sample;
+
+                if (++fillCount < blockSize) {
+                    return;
+                }
+
+                fillCount = 0;
+
+                if (sending == NOT_SENDING) {
+                    send(filling);
+                    filling ^= 1;
+                } else {
+                    dropped++;
+                }
+
+                sequence++;
+                sums[filling] = 0;
+            }
+
+            //--------------------------------------------------------------
+            // Call this from ISR(USART_UDRE_vect).
+            //--------------------------------------------------------------
+            static void handleTransmit() {
+                UDR0 = *txNext++;
+
+                if (--txRemaining) {
+                    return;
+                }
+
+                // On to the next part of the frame.
+                switch (++txStage) {
+                    case 1:
+                        txNext = reinterpret_cast<const uint8_t *>(blocks[sending]);
+                        txRemaining = blockSize * 2;
+                        break;
+
+                    case 2:
+                        txNext = trailer;
+                        txRemaining = sizeof(trailer);
+                        break;
+
+                    default:
+                        sending = NOT_SENDING;
+                        Usart::disableDataEmptyInterrupt();
+                        break;
+                }
+            }
+
+        private:
+            static const uint8_t NOT_SENDING = 0xFF;
+
+            //--------------------------------------------------------------
+            // Hand a full block over to the transmitter. Only called from
+            // the ADC ISR, and only when the transmitter is idle.
+            //--------------------------------------------------------------
+            static void send(const uint8_t block) {
+                uint16_t checksum = sums[block] + sequence;
+
+                header[2] = sequence;
+                trailer[0] = checksum & 0xFF;
+                trailer[1] = checksum >> 8;
+
+                txNext = header;
+                txRemaining = sizeof(header);
+                txStage = 0;
+                sending = block;
+                Usart::enableDataEmptyInterrupt();
+            }
+
+            static uint16_t blocks[2][blockSize];
+            static uint16_t sums[2];
+            static uint8_t filling;
+            static uint8_t fillCount;
+            static uint8_t sequence;
+            static volatile uint8_t sending;
+
+            static uint8_t header[4];
+            static uint8_t trailer[2];
+            static const uint8_t *txNext;
+            static uint8_t txRemaining;
+            static uint8_t txStage;
+        };
+
+        template <uint8_t blockSize>
+        volatile uint8_t Streamer<blockSize>::dropped;
+
+        template <uint8_t blockSize>
+        uint16_t Streamer<blockSize>::blocks[2][blockSize];
+
+        template <uint8_t blockSize>
+        uint16_t Streamer<blockSize>::sums[2];
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::filling;
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::fillCount;
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::sequence;
+
+        template <uint8_t blockSize>
+        volatile uint8_t Streamer<blockSize>::sending = Streamer<blockSize>::NOT_SENDING;
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::header[4] = { STREAM_SYNC_1, STREAM_SYNC_2, 0, blockSize };
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::trailer[2];
+
+        template <uint8_t blockSize>
+        const uint8_t *Streamer<blockSize>::txNext;
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::txRemaining;
+
+        template <uint8_t blockSize>
+        uint8_t Streamer<blockSize>::txStage;
+
+    } // End of Adc namespace.
+
+}  // End of AVRAssist namespace.
+#endif // __ADCSTREAM_H__
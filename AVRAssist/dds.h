@@ -0,0 +1,228 @@
+#ifndef __DDS_H__
+#define __DDS_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "timer2.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Direct digital synthesis, a cheap function generator.
+    //
+    // Timer 2 runs in fast PWM mode, TOP = 255, with no prescaler, so the
+    // PWM carrier on OC2A (physical pin 17, Arduino pin D11 or AVR pin
+    // PB3) is F_CPU / 256, 62.5 KHz at 16 MHz. Each overflow interrupt
+    // adds the increment to a 24 bit phase accumulator and looks up the
+    // next sample, from a 256 byte wavetable in flash, using the top 8
+    // bits of the phase. OCR2A is double buffered in this mode, so the
+    // new sample starts with the next PWM period.
+    //
+    // Output frequency = increment * F_CPU / 2^32, so the increment for
+    // a frequency is frequency * 2^32 / F_CPU, about 268.4 per Hz at
+    // 16 MHz, and the resolution is under 0.004 Hz.
+    //
+    // Put a low pass filter on the pin, to remove the carrier.
+    //
+    // Usage:
+    //
+    // ISR(TIMER2_OVF_vect) { Dds::handleInterrupt(); }
+    // ...
+    // Dds::initialise(Dds::sineWave(), 1000);
+    // sei();
+    // ...
+    // Dds::setFrequency(440);
+    // Dds::setWave(Dds::triangleWave());
+    //----------------------------------------------------------------------
+    namespace Dds {
+
+        //------------------------------------------------------------------
+        // A hand estimate of the worst case cycles for handleInterrupt().
+        // It hasn't been taken from compiler output or timed on hardware,
+        // the instructions were written out by hand, as avr-gcc might
+        // compile them, and added up:
+        //
+        //  7 cycles  interrupt response and the jmp in the vector table.
+        //  4 cycles  at most, finishing the instruction running at the time.
+        // 28 cycles  prologue, SREG, r0, r1 and ten registers saved.
+        // 39 cycles  the 32 bit add, the store, and the table lookup.
+        // 31 cycles  epilogue and reti.
+        //
+        // That's 109, rounded up to 110, against 256 cycles per PWM
+        // period. The real figure depends on the compiler and its options,
+        // so before relying on it, count the vector's instructions in the
+        // avr-objdump -d listing of your build.
+        //------------------------------------------------------------------
+        const uint16_t DDS_ISR_CYCLES = 110;
+
+        //------------------------------------------------------------------
+        // The highest frequency, half the sample rate, F_CPU / 512. Above
+        // this, there are fewer than two samples per cycle and the output
+        // aliases back down to a lower frequency.
+        //------------------------------------------------------------------
+        const uint16_t DDS_MAX_FREQUENCY = F_CPU / 256 / 2;
+
+        //------------------------------------------------------------------
+        // The increment for a frequency in Hz, worked out as
+        // (frequency * 2^40 / F_CPU) / 2^8, and clamped to
+        // DDS_MAX_FREQUENCY. Anything up to that stays within 32 bits,
+        // which is checked below with 64 bit sums, so it's cheap enough
+        // to use at run time too.
+        //------------------------------------------------------------------
+        const uint32_t DDS_SCALE = (uint64_t(1) << 40) / F_CPU;
+
+        static_assert(F_CPU / 256 / 2 <= 65535,
+                      "F_CPU is too high for a 16 bit DDS frequency.");
+        static_assert(uint64_t(DDS_MAX_FREQUENCY) * DDS_SCALE <= 0xFFFFFFFFULL,
+                      "DDS increment overflows 32 bits.");
+
+        constexpr uint32_t incrementFor(const uint16_t frequency) {
+            return (uint32_t(frequency > DDS_MAX_FREQUENCY ? DDS_MAX_FREQUENCY : frequency) * DDS_SCALE) >> 8;
+        }
+
+        //------------------------------------------------------------------
+        // The built in wavetables, 256 samples each, in flash. Your own
+        // tables must also be 256 bytes and PROGMEM.
+        //------------------------------------------------------------------
+        inline const uint8_t *sineWave() {
+            static const uint8_t table[256] PROGMEM = {
+                128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+                176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+                218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+                245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+                255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+                245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+                218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+                176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+                128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+                 79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+                 37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+                 10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+                  0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+                 10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+                 37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+                 79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124
+            };
+            return table;
+        }
+
+        inline const uint8_t *triangleWave() {
+            static const uint8_t table[256] PROGMEM = {
+                  0,   2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,
+                 32,  34,  36,  38,  40,  42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,
+                 64,  66,  68,  70,  72,  74,  76,  78,  80,  82,  84,  86,  88,  90,  92,  94,
+                 96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
+                128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158,
+                160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190,
+                192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220, 222,
+                224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 252, 254,
+                255, 253, 251, 249, 247, 245, 243, 241, 239, 237, 235, 233, 231, 229, 227, 225,
+                223, 221, 219, 217, 215, 213, 211, 209, 207, 205, 203, 201, 199, 197, 195, 193,
+                191, 189, 187, 185, 183, 181, 179, 177, 175, 173, 171, 169, 167, 165, 163, 161,
+                159, 157, 155, 153, 151, 149, 147, 145, 143, 141, 139, 137, 135, 133, 131, 129,
+                127, 125, 123, 121, 119, 117, 115, 113, 111, 109, 107, 105, 103, 101,  99,  97,
+                 95,  93,  91,  89,  87,  85,  83,  81,  79,  77,  75,  73,  71,  69,  67,  65,
+                 63,  61,  59,  57,  55,  53,  51,  49,  47,  45,  43,  41,  39,  37,  35,  33,
+                 31,  29,  27,  25,  23,  21,  19,  17,  15,  13,  11,   9,   7,   5,   3,   1
+            };
+            return table;
+        }
+
+        //------------------------------------------------------------------
+        // The generator, shared by the main loop and handleInterrupt().
+        //------------------------------------------------------------------
+        struct state_t {
+            uint32_t phase;                 // Only the low 24 bits matter.
+            uint32_t increment;
+            const uint8_t *wave;            // In flash.
+        };
+
+        inline volatile state_t &state() {
+            static volatile state_t generator;
+            return generator;
+        }
+
+        //------------------------------------------------------------------
+        // Change the increment. Interrupts are off for the four byte
+        // write, so the ISR never sees half an old and half a new value.
+        // The phase carries on from where it was, so the waveform changes
+        // frequency without a jump.
+        //------------------------------------------------------------------
+        inline void setIncrement(const uint32_t increment) {
+            uint8_t oldSREG = SREG;
+            cli();
+            state().increment = increment;
+            SREG = oldSREG;
+        }
+
+        inline void setFrequency(const uint16_t frequency) {
+            setIncrement(incrementFor(frequency));
+        }
+
+        //------------------------------------------------------------------
+        // Change the wavetable, from the next sample.
+        //------------------------------------------------------------------
+        inline void setWave(const uint8_t *wave) {
+            uint8_t oldSREG = SREG;
+            cli();
+            state().wave = wave;
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Make OC2A an output and start Timer 2, with the overflow
+        // interrupt enabled. Interrupts need to be enabled, by you, for
+        // anything to happen.
+        //------------------------------------------------------------------
+        inline void initialise(const uint8_t *wave, const uint16_t frequency) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            volatile state_t &generator = state();
+            generator.phase = 0;
+            generator.increment = incrementFor(frequency);
+            generator.wave = wave;
+
+            OCR2A = pgm_read_byte(wave);
+            DDRB |= (1 << PB3);
+
+            Timer2::initialise(Timer2::MODE_FAST_PWM_255,
+                               Timer2::CLK_PRESCALE_1,
+                               Timer2::OC2A_CLEAR,
+                               Timer2::INT_OVERFLOW);
+            TCNT2 = 0;
+            TIFR2 = (1 << TOV2);
+
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER2_OVF_vect). It has to be done in one PWM
+        // period, so keep the ISR to just this.
+        //------------------------------------------------------------------
+        inline void handleInterrupt() {
+            volatile state_t &generator = state();
+            uint32_t phase = generator.phase + generator.increment;
+            generator.phase = phase;
+            OCR2A = pgm_read_byte(generator.wave + uint8_t(phase >> 16));
+        }
+
+    }  // End of Dds namespace.
+
+}  // End of AVRAssist namespace.
+
+#endif // __DDS_H__
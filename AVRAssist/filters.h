@@ -0,0 +1,244 @@
+#ifndef __FILTERS_H__
+#define __FILTERS_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Fixed point filters for ADC samples, small and quick enough to run
+    // in ISR(ADC_vect). Every filter has the same function:
+    //
+    //     bool process(const uint16_t input, uint16_t &output);
+    //
+    // which returns true if a new output was produced. Only a decimating
+    // filter ever returns false. Filters can be joined together with
+    // Chain<>, and a filter that isn't used is never compiled.
+    //
+    // Cycle counts given are rough guides for the ATmega328P, worked out
+    // by hand from the C++, not from compiler output, and not including
+    // the call itself. They aren't worst case budgets. If you are tight
+    // for time, measure them for your own build.
+    //----------------------------------------------------------------------
+    namespace Filter {
+
+        //------------------------------------------------------------------
+        // log2() of a power of two, at compile time.
+        //------------------------------------------------------------------
+        constexpr uint8_t log2(const uint8_t value) {
+            return value <= 1 ? 0 : 1 + log2(value >> 1);
+        }
+
+        constexpr bool powerOfTwo(const uint8_t value) {
+            return value && !(value & (value - 1));
+        }
+
+        //------------------------------------------------------------------
+        // Moving average of the last 'length' samples. A running total is
+        // kept, so the cost doesn't depend on the length. The length must
+        // be a power of two, 2 to 64.
+        //
+        // Roughly 45 + 6 x log2(length) cycles.
+        //------------------------------------------------------------------
+        template <uint8_t length>
+        class MovingAverage {
+            static_assert(powerOfTwo(length) && length >= 2 && length <= 64,
+                          "MovingAverage length must be a power of two, 2 to 64.");
+
+        public:
+            MovingAverage() : total(0), next(0), history() {}
+
+            bool process(const uint16_t input, uint16_t &output) {
+                total -= history[next];
+                total += input;
+                history[next] = input;
+                next = (next + 1) & (length - 1);
+                output = total >> log2(length);
+                return true;
+            }
+
+        private:
+            uint32_t total;
+            uint8_t next;
+            uint16_t history[length];
+        };
+
+        //------------------------------------------------------------------
+        // Single pole IIR low pass filter, y += (x - y) / 2^shift. The
+        // state is kept scaled up by 2^shift so nothing is lost to
+        // rounding. The larger the shift, the heavier the filtering.
+        //
+        // Roughly 25 + 6 x shift cycles.
+        //------------------------------------------------------------------
+        template <uint8_t shift>
+        class SinglePole {
+            static_assert(shift >= 1 && shift <= 8,
+                          "SinglePole shift must be 1 to 8.");
+
+        public:
+            SinglePole() : state(0) {}
+
+            bool process(const uint16_t input, uint16_t &output) {
+                state -= state >> shift;
+                state += input;
+                output = state >> shift;
+                return true;
+            }
+
+        private:
+            uint32_t state;
+        };
+
+        //------------------------------------------------------------------
+        // Median of the last 'length' samples, which must be odd, 3 to 9.
+        // Good for throwing away the odd spike. The history is copied and
+        // insertion sorted on every sample.
+        //
+        // Roughly 40 + 14 x length x (length - 1) / 2 cycles,
+        // so around 85 for 3, 180 for 5 and 550 for 9.
+        //------------------------------------------------------------------
+        template <uint8_t length>
+        class Median {
+            static_assert((length & 1) && length >= 3 && length <= 9,
+                          "Median length must be odd, 3 to 9.");
+
+        public:
+            Median() : next(0), history() {}
+
+            bool process(const uint16_t input, uint16_t &output) {
+                history[next] = input;
+                if (++next == length) {
+                    next = 0;
+                }
+
+                uint16_t sorted[length];
+                for (uint8_t i = 0; i < length; i++) {
+                    uint16_t value = history[i];
+                    uint8_t j = i;
+
+                    while (j && sorted[j - 1] > value) {
+                        sorted[j] = sorted[j - 1];
+                        j--;
+                    }
+
+                    sorted[j] = value;
+                }
+
+                output = sorted[length / 2];
+                return true;
+            }
+
+        private:
+            uint8_t next;
+            uint16_t history[length];
+        };
+
+        //------------------------------------------------------------------
+        // Decimating CIC (cascaded integrator comb) filter. Produces one
+        // output for every 'decimation' inputs, using only additions and
+        // subtractions. The output is scaled back down to the same range
+        // as the input. The decimation must be a power of two, and the
+        // filter can have 1 to 4 stages.
+        //
+        // The arithmetic relies on 32 bit wrap around, which is why the
+        // bit growth, stages x log2(decimation), is limited to 16 bits.
+        //
+        // Roughly 20 + 16 x stages cycles for an input with
+        // no output, 40 + 40 x stages + 6 x stages x log2(decimation)
+        // cycles for an input that produces an output.
+        //------------------------------------------------------------------
+        template <uint8_t decimation, uint8_t stages = 1>
+        class Cic {
+            static_assert(powerOfTwo(decimation) && decimation >= 2,
+                          "Cic decimation must be a power of two, at least 2.");
+            static_assert(stages >= 1 && stages <= 4,
+                          "Cic must have 1 to 4 stages.");
+            static_assert(stages * log2(decimation) <= 16,
+                          "Cic bit growth is too large for 32 bits.");
+
+        public:
+            Cic() : count(0), integrators(), delays() {}
+
+            bool process(const uint16_t input, uint16_t &output) {
+                uint32_t value = input;
+
+                for (uint8_t i = 0; i < stages; i++) {
+                    integrators[i] += value;
+                    value = integrators[i];
+                }
+
+                if (++count < decimation) {
+                    return false;
+                }
+
+                count = 0;
+
+                for (uint8_t i = 0; i < stages; i++) {
+                    uint32_t previous = delays[i];
+                    delays[i] = value;
+                    value -= previous;
+                }
+
+                output = value >> (stages * log2(decimation));
+                return true;
+            }
+
+        private:
+            uint8_t count;
+            uint32_t integrators[stages];
+            uint32_t delays[stages];
+        };
+
+        //------------------------------------------------------------------
+        // A chain of filters, applied in the order given. The output of
+        // each feeds the input of the next. Returns true when the last
+        // filter in the chain produces an output.
+        //
+        // Usage:
+        //
+        // Filter::Chain<Filter::Median<3>, Filter::SinglePole<3> > smooth;
+        // ISR(ADC_vect) {
+        //     uint16_t result;
+        //     if (smooth.process(ADCW, result)) { ... }
+        // }
+        //------------------------------------------------------------------
+        template <typename... filters>
+        class Chain;
+
+        template <>
+        class Chain<> {
+        public:
+            bool process(const uint16_t input, uint16_t &output) {
+                output = input;
+                return true;
+            }
+        };
+
+        template <typename first, typename... rest>
+        class Chain<first, rest...> {
+        public:
+            bool process(const uint16_t input, uint16_t &output) {
+                uint16_t intermediate;
+                return head.process(input, intermediate) &&
+                       tail.process(intermediate, output);
+            }
+
+        private:
+            first head;
+            Chain<rest...> tail;
+        };
+
+    } // End of Filter namespace.
+
+}  // End of AVRAssist namespace.
+#endif // __FILTERS_H__
@@ -0,0 +1,274 @@
+#ifndef __INPUTCAPTURE_H__
+#define __INPUTCAPTURE_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+#include "timer1.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Frequency and period meter, using Timer 1 input capture on pin ICP1
+    // (physical pin 14, Arduino pin D8 or AVR pin PB0).
+    //
+    // Timer 1 runs freely in normal mode. The overflow interrupt counts
+    // the top 16 bits, so each capture gets a 32 bit time stamp, and
+    // periods of over four minutes can be measured at 16 MHz with no
+    // prescaler.
+    //
+    // The average is over the last 2^averageShift periods, worked out
+    // from the time stamp that many captures ago, so it is exact and
+    // needs no division in the ISR.
+    //
+    // Usage:
+    //
+    // typedef CaptureMeter<3> Meter;
+    // ISR(TIMER1_CAPT_vect) { Meter::handleCapture(); }
+    // ISR(TIMER1_OVF_vect) { Meter::handleOverflow(); }
+    // ...
+    // Meter::initialise(Timer1::INPCAP_NOISE_CANCEL_ON_RISING_EDGE);
+    // sei();
+    // ...
+    // if (Meter::available()) { uint32_t hertz = Meter::frequency(); }
+    //----------------------------------------------------------------------
+    template <uint8_t averageShift = 3>
+    class CaptureMeter {
+        static_assert(averageShift <= 5,
+                      "CaptureMeter can average up to 32 periods.");
+
+    public:
+        static const uint8_t averageCount = 1 << averageShift;
+
+        //------------------------------------------------------------------
+        // Start Timer 1 in normal mode, with the capture and overflow
+        // interrupts. The edge, and whether the noise canceller is on, is
+        // one of the Timer1::INPCAP_xxx values. The noise canceller needs
+        // four identical samples of the pin, so it delays each capture by
+        // four CPU clocks, but it delays them all equally.
+        //
+        // The clock source must be one of the CLK_PRESCALE_xxx values.
+        // Anything else, CLK_DISABLED or an external clock on T1, has no
+        // known frequency to measure against, so nothing is started.
+        //------------------------------------------------------------------
+        static void initialise(const Timer1::inputCapture_t inputCapture,
+                               const Timer1::clockSource_t clockSource = Timer1::CLK_PRESCALE_1) {
+            if (!Timer1::prescaleDivisor(clockSource)) {
+                return;
+            }
+
+            uint8_t oldSREG = SREG;
+            cli();
+
+            overflows = 0;
+            captures = 0;
+            next = 0;
+            prescale = Timer1::prescaleDivisor(clockSource);
+
+            Timer1::initialise(Timer1::MODE_NORMAL,
+                               clockSource,
+                               Timer1::OC1X_DISCONNECTED,
+                               Timer1::interrupt_t(Timer1::INT_CAPTURE | Timer1::INT_OVERFLOW),
+                               inputCapture);
+            TCNT1 = 0;
+            TIFR1 = (1 << ICF1) | (1 << TOV1);
+
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER1_OVF_vect).
+        //------------------------------------------------------------------
+        static void handleOverflow() {
+            overflows++;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER1_CAPT_vect).
+        //
+        // If TCNT1 overflowed around the time of the capture, the
+        // overflow interrupt may still be pending, as the capture
+        // interrupt has the higher priority. If so, a small ICR1 means the
+        // capture came after the overflow, so it belongs to the next
+        // count. A large ICR1 means it came before, and the count is
+        // already right.
+        //------------------------------------------------------------------
+        static void handleCapture() {
+            uint16_t low = ICR1;
+            uint16_t high = overflows;
+
+            if ((TIFR1 & (1 << TOV1)) && low < 0x8000) {
+                high++;
+            }
+
+            uint32_t stamp = (uint32_t(high) << 16) | low;
+
+            if (captures) {
+                lastPeriod = stamp - previous;
+            }
+
+            if (captures >= averageCount) {
+                averageSpan = stamp - history[next];
+            }
+
+            previous = stamp;
+            history[next] = stamp;
+            next = (next + 1) & (averageCount - 1);
+
+            if (captures <= averageCount) {
+                captures++;
+            }
+
+            fresh = true;
+        }
+
+        //------------------------------------------------------------------
+        // Has a new period been measured since the last call to period(),
+        // or frequency()?
+        //------------------------------------------------------------------
+        static bool available() {
+            return fresh;
+        }
+
+        //------------------------------------------------------------------
+        // Has the average got enough periods to be valid?
+        //------------------------------------------------------------------
+        static bool averageAvailable() {
+            return captures > averageCount;
+        }
+
+        //------------------------------------------------------------------
+        // The last period, in timer counts. Zero until two edges have
+        // been seen.
+        //------------------------------------------------------------------
+        static uint32_t period() {
+            uint8_t oldSREG = SREG;
+            cli();
+            uint32_t counts = captures > 1 ? lastPeriod : 0;
+            fresh = false;
+            SREG = oldSREG;
+            return counts;
+        }
+
+        //------------------------------------------------------------------
+        // The average of the last 2^averageShift periods, in timer
+        // counts, rounded. Zero until there have been enough edges.
+        //------------------------------------------------------------------
+        static uint32_t averagePeriod() {
+            uint32_t span = averageTotal();
+            return (span + (averageCount >> 1)) >> averageShift;
+        }
+
+        //------------------------------------------------------------------
+        // The last period in microseconds.
+        //------------------------------------------------------------------
+        static uint32_t periodMicros() {
+            return countsToMicros(period());
+        }
+
+        //------------------------------------------------------------------
+        // Frequency, in Hz, rounded, from the last period. Zero until two
+        // edges have been seen.
+        //------------------------------------------------------------------
+        static uint32_t frequency() {
+            uint32_t counts = period();
+            return counts ? (timerClock() + (counts >> 1)) / counts : 0;
+        }
+
+        //------------------------------------------------------------------
+        // Frequency, in Hz, rounded, from the last 2^averageShift periods.
+        // This is better than averaging frequency() as it is worked out
+        // from the total time.
+        //------------------------------------------------------------------
+        static uint32_t averageFrequency() {
+            uint32_t span = averageTotal();
+            return span ? ((timerClock() << averageShift) + (span >> 1)) / span : 0;
+        }
+
+    private:
+        static uint32_t timerClock() {
+            return F_CPU / prescale;
+        }
+
+        //------------------------------------------------------------------
+        // counts * prescale / F_CPU seconds. The two shortcuts avoid 64 bit
+        // arithmetic for all the prescalers at 16 and 8 MHz, and are only
+        // taken when they're exact. Anything else, 14.7456 MHz say, or
+        // under 1 MHz, takes the long way round.
+        //------------------------------------------------------------------
+        static uint32_t countsToMicros(const uint32_t counts) {
+            if (F_CPU % (uint32_t(prescale) * 1000000) == 0) {
+                return counts / (F_CPU / (uint32_t(prescale) * 1000000));
+            }
+
+            // One, rather than zero, below 1 MHz, where it isn't used.
+            const uint32_t megahertz = F_CPU >= 1000000 ? F_CPU / 1000000 : 1;
+
+            if (F_CPU % 1000000 == 0 && prescale % megahertz == 0) {
+                return counts * (prescale / megahertz);
+            }
+
+            return uint64_t(counts) * prescale * 1000000UL / F_CPU;
+        }
+
+        static uint32_t averageTotal() {
+            uint8_t oldSREG = SREG;
+            cli();
+            uint32_t span = captures > averageCount ? averageSpan : 0;
+            SREG = oldSREG;
+            return span;
+        }
+
+        static uint16_t overflows;          // Top 16 bits of the time stamp.
+        static uint32_t previous;           // Last time stamp.
+        static uint32_t lastPeriod;
+        static uint32_t averageSpan;        // Time for the last averageCount periods.
+        static uint32_t history[averageCount];
+        static uint8_t next;                // Oldest entry in history[].
+        static volatile uint8_t captures;   // Stops counting at averageCount + 1.
+        static uint16_t prescale;
+        static volatile bool fresh;
+    };
+
+    template <uint8_t averageShift>
+    uint16_t CaptureMeter<averageShift>::overflows;
+
+    template <uint8_t averageShift>
+    uint32_t CaptureMeter<averageShift>::previous;
+
+    template <uint8_t averageShift>
+    uint32_t CaptureMeter<averageShift>::lastPeriod;
+
+    template <uint8_t averageShift>
+    uint32_t CaptureMeter<averageShift>::averageSpan;
+
+    template <uint8_t averageShift>
+    uint32_t CaptureMeter<averageShift>::history[CaptureMeter<averageShift>::averageCount];
+
+    template <uint8_t averageShift>
+    uint8_t CaptureMeter<averageShift>::next;
+
+    template <uint8_t averageShift>
+    volatile uint8_t CaptureMeter<averageShift>::captures;
+
+    template <uint8_t averageShift>
+    uint16_t CaptureMeter<averageShift>::prescale = 1;
+
+    template <uint8_t averageShift>
+    volatile bool CaptureMeter<averageShift>::fresh;
+
+}  // End of AVRAssist namespace.
+
+#endif // __INPUTCAPTURE_H__
@@ -0,0 +1,249 @@
+#ifndef __PWM_H__
+#define __PWM_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // PWM output channels, A is OCnA and B is OCnB.
+    //----------------------------------------------------------------------
+    enum pwmChannel_t : uint8_t {
+        PWM_A = 0,
+        PWM_B
+    };
+
+    //----------------------------------------------------------------------
+    // The registers for each timer. Timer 1 has 16 bit duty values, the
+    // others 8 bit.
+    //
+    // mode() reads the mode number back from the timer's WGM bits, and
+    // enableInterrupt() turns on whichever interrupt comes at the end of
+    // a period in that mode. That's compare match A in the CTC mode with
+    // TOP in OCRnA, input capture for Timer 1's CTC mode with TOP in
+    // ICR1, and overflow in the normal and PWM modes.
+    //----------------------------------------------------------------------
+    template <uint8_t timerNumber>
+    struct PwmRegisters {
+        static_assert(timerNumber <= 2, "There are only Timers 0, 1 and 2.");
+    };
+
+    template <>
+    struct PwmRegisters<0> {
+        typedef uint8_t duty_t;
+        static void write(const duty_t a, const duty_t b) { OCR0A = a; OCR0B = b; }
+        static duty_t read(const pwmChannel_t channel) { return channel == PWM_A ? OCR0A : OCR0B; }
+
+        static uint8_t mode() {
+            return ((TCCR0A & (1 << WGM00)) ? 1 : 0) |
+                   ((TCCR0A & (1 << WGM01)) ? 2 : 0) |
+                   ((TCCR0B & (1 << WGM02)) ? 4 : 0);
+        }
+
+        static void enableInterrupt() {
+            // Mode 2 is CTC, the period ends at OCR0A.
+            TIMSK0 |= (mode() == 2) ? (1 << OCIE0A) : (1 << TOIE0);
+        }
+    };
+
+    template <>
+    struct PwmRegisters<1> {
+        typedef uint16_t duty_t;
+        static void write(const duty_t a, const duty_t b) { OCR1A = a; OCR1B = b; }
+        static duty_t read(const pwmChannel_t channel) { return channel == PWM_A ? OCR1A : OCR1B; }
+
+        static uint8_t mode() {
+            return ((TCCR1A & (1 << WGM10)) ? 1 : 0) |
+                   ((TCCR1A & (1 << WGM11)) ? 2 : 0) |
+                   ((TCCR1B & (1 << WGM12)) ? 4 : 0) |
+                   ((TCCR1B & (1 << WGM13)) ? 8 : 0);
+        }
+
+        static void enableInterrupt() {
+            // Mode 4 is CTC with TOP in OCR1A and mode 12 is CTC with TOP
+            // in ICR1, which sets ICF1 at TOP.
+            uint8_t timerMode = mode();
+            TIMSK1 |= (timerMode == 4) ? (1 << OCIE1A) :
+                      (timerMode == 12) ? (1 << ICIE1) : (1 << TOIE1);
+        }
+    };
+
+    template <>
+    struct PwmRegisters<2> {
+        typedef uint8_t duty_t;
+        static void write(const duty_t a, const duty_t b) { OCR2A = a; OCR2B = b; }
+        static duty_t read(const pwmChannel_t channel) { return channel == PWM_A ? OCR2A : OCR2B; }
+
+        static uint8_t mode() {
+            return ((TCCR2A & (1 << WGM20)) ? 1 : 0) |
+                   ((TCCR2A & (1 << WGM21)) ? 2 : 0) |
+                   ((TCCR2B & (1 << WGM22)) ? 4 : 0);
+        }
+
+        static void enableInterrupt() {
+            // Mode 2 is CTC, the period ends at OCR2A.
+            TIMSK2 |= (mode() == 2) ? (1 << OCIE2A) : (1 << TOIE2);
+        }
+    };
+
+    //----------------------------------------------------------------------
+    // Buffered PWM duty cycles for one timer.
+    //
+    // New duty cycles are staged in a shadow copy, from the main loop,
+    // then committed. The timer's interrupt handler then writes both
+    // OCRnA and OCRnB together, at the end of a period, so both channels
+    // change in the same PWM period, and never part way through one.
+    //
+    // The timer must already be set up, with its initialise() function,
+    // in the mode you want, before Pwm<n>::initialise() is called, as
+    // that picks the interrupt from the mode. Call handleInterrupt() from
+    // the matching vector:
+    //
+    // PWM modes            - TIMERn_OVF_vect, at TOP in the fast PWM
+    //                        modes and at BOTTOM in the phase correct ones.
+    // Normal mode          - TIMERn_OVF_vect, at MAX.
+    // CTC mode, OCRnA      - TIMERn_COMPA_vect.
+    // Timer 1 CTC, ICR1    - TIMER1_CAPT_vect.
+    //
+    // Pwm<0> can't be used with the Arduino core. Its PWM modes need
+    // TIMER0_OVF_vect, which the core already defines for millis(), and
+    // any other mode would stop millis() anyway.
+    //
+    // Usage:
+    //
+    // ISR(TIMER1_OVF_vect) { Pwm<1>::handleInterrupt(); }
+    // ...
+    // Pwm<1>::initialise();
+    // Pwm<1>::stage(PWM_A, red);
+    // Pwm<1>::stage(PWM_B, green);
+    // Pwm<1>::commit();
+    //----------------------------------------------------------------------
+    template <uint8_t timerNumber>
+    class Pwm {
+#if defined(ARDUINO)
+        static_assert(timerNumber != 0,
+                      "Pwm<0> needs TIMER0_OVF_vect, which the Arduino core uses for millis().");
+#endif
+
+    public:
+        typedef PwmRegisters<timerNumber> registers;
+        typedef typename registers::duty_t duty_t;
+
+        //------------------------------------------------------------------
+        // Start from the duty cycles already in OCRnA and OCRnB, and turn
+        // on the end of period interrupt for the timer's current mode.
+        // Nothing else is changed.
+        //------------------------------------------------------------------
+        static void initialise() {
+            uint8_t oldSREG = SREG;
+            cli();
+            shadow[PWM_A] = registers::read(PWM_A);
+            shadow[PWM_B] = registers::read(PWM_B);
+            committed = false;
+            registers::enableInterrupt();
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Set a new duty cycle, to be applied at the next commit(). If the
+        // last commit() hasn't been applied yet, this waits for it, at
+        // most one PWM period, so don't call it with interrupts off.
+        //------------------------------------------------------------------
+        static void stage(const pwmChannel_t channel, const duty_t duty) {
+            while (committed) {
+                ;
+            }
+
+            shadow[channel] = duty;
+        }
+
+        //------------------------------------------------------------------
+        // Apply everything staged, at the end of the current period.
+        //------------------------------------------------------------------
+        static void commit() {
+            __asm__ __volatile__ ("" ::: "memory");
+            committed = true;
+        }
+
+        //------------------------------------------------------------------
+        // Stage and commit one channel.
+        //------------------------------------------------------------------
+        static void set(const pwmChannel_t channel, const duty_t duty) {
+            stage(channel, duty);
+            commit();
+        }
+
+        //------------------------------------------------------------------
+        // Is there a commit waiting for the end of the period?
+        //------------------------------------------------------------------
+        static bool pending() {
+            return committed;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from the interrupt initialise() enabled, see above.
+        // Interrupts are off in here, so the 16 bit Timer 1 writes are
+        // safe.
+        //------------------------------------------------------------------
+        static void handleInterrupt() {
+            if (committed) {
+                registers::write(shadow[PWM_A], shadow[PWM_B]);
+                committed = false;
+            }
+        }
+
+    private:
+        static duty_t shadow[2];
+        static volatile bool committed;
+    };
+
+    template <uint8_t timerNumber>
+    typename Pwm<timerNumber>::duty_t Pwm<timerNumber>::shadow[2];
+
+    template <uint8_t timerNumber>
+    volatile bool Pwm<timerNumber>::committed;
+
+    //----------------------------------------------------------------------
+    // Commit several timers at once, with interrupts off, so none of them
+    // can reach the end of its period part way through. If the timers
+    // run in step, with the same prescaler and TOP, started together,
+    // see Timers::startTogether() in timer.h, the new duty cycles all
+    // start in the same period.
+    //
+    // commitTogether<Pwm<0>, Pwm<2>>();
+    //----------------------------------------------------------------------
+    template <typename Only>
+    inline void commitEach() {
+        Only::commit();
+    }
+
+    template <typename First, typename Second, typename... Rest>
+    inline void commitEach() {
+        First::commit();
+        commitEach<Second, Rest...>();
+    }
+
+    template <typename... Timers>
+    inline void commitTogether() {
+        uint8_t oldSREG = SREG;
+        cli();
+        commitEach<Timers...>();
+        SREG = oldSREG;
+    }
+
+}  // End of AVRAssist namespace.
+
+#endif // __PWM_H__
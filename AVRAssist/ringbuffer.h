@@ -0,0 +1,121 @@
+#ifndef __RINGBUFFER_H__
+#define __RINGBUFFER_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Single producer, single consumer, ring buffer.
+    //
+    // One side, usually an ISR, calls push() and the other side, usually
+    // the main loop, calls pop() or read(). Each index is only ever
+    // written by one side and is a single byte, so reads and writes of it
+    // are atomic on the AVR. Neither side needs to disable interrupts.
+    //
+    // The size must be a power of two, between 2 and 128. One slot is
+    // always left empty to tell a full buffer from an empty one, so the
+    // buffer holds, at most, size - 1 items.
+    //----------------------------------------------------------------------
+    template <typename T, uint8_t size>
+    class RingBuffer {
+        static_assert(size >= 2 && size <= 128 && (size & (size - 1)) == 0,
+                      "RingBuffer size must be a power of two, 2 to 128.");
+
+    public:
+        RingBuffer() : overruns(0), head(0), tail(0) {}
+
+        //------------------------------------------------------------------
+        // Producer side. Add a value, returns false, and counts an overrun,
+        // if the buffer is full. The value is stored before the head index
+        // moves, so the consumer never sees a half written value.
+        //------------------------------------------------------------------
+        bool push(const T value) {
+            uint8_t current = head;
+            uint8_t next = (current + 1) & mask;
+
+            if (next == tail) {
+                overruns++;
+                return false;
+            }
+
+            buffer[current] = value;
+            __asm__ __volatile__ ("" ::: "memory");
+            head = next;
+            return true;
+        }
+
+        //------------------------------------------------------------------
+        // Consumer side. Fetch a single value, returns false if there
+        // isn't one.
+        //------------------------------------------------------------------
+        bool pop(T &value) {
+            uint8_t current = tail;
+
+            if (current == head) {
+                return false;
+            }
+
+            value = buffer[current];
+            __asm__ __volatile__ ("" ::: "memory");
+            tail = (current + 1) & mask;
+            return true;
+        }
+
+        //------------------------------------------------------------------
+        // Consumer side. Drain up to 'maximum' values into 'destination'
+        // in one go, returns the number copied. The tail index is only
+        // updated once, at the end.
+        //------------------------------------------------------------------
+        uint8_t read(T *destination, const uint8_t maximum) {
+            uint8_t current = tail;
+            uint8_t count = (head - current) & mask;
+
+            if (count > maximum) {
+                count = maximum;
+            }
+
+            for (uint8_t i = 0; i < count; i++) {
+                destination[i] = buffer[current];
+                current = (current + 1) & mask;
+            }
+
+            __asm__ __volatile__ ("" ::: "memory");
+            tail = current;
+            return count;
+        }
+
+        //------------------------------------------------------------------
+        // How many values are waiting? Safe to call from either side.
+        //------------------------------------------------------------------
+        uint8_t available() const {
+            return (head - tail) & mask;
+        }
+
+        //------------------------------------------------------------------
+        // Number of values the producer had to throw away as the buffer
+        // was full. Only the producer writes this.
+        //------------------------------------------------------------------
+        volatile uint8_t overruns;
+
+    private:
+        static const uint8_t mask = size - 1;
+
+        T buffer[size];
+        volatile uint8_t head;      // Written by the producer only.
+        volatile uint8_t tail;      // Written by the consumer only.
+    };
+
+}  // End of AVRAssist namespace.
+
+#endif // __RINGBUFFER_H__
@@ -0,0 +1,176 @@
+#ifndef __RTC_H__
+#define __RTC_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "seqcount.h"
+#include "timer2.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // A real time clock, on Timer 2 running from a 32.768 KHz watch
+    // crystal. 32,768 / 128 / 256 is exactly one overflow per second,
+    // and it carries on while the CPU is in power save sleep.
+    //
+    // Usage:
+    //
+    // ISR(TIMER2_OVF_vect) {
+    //     Rtc::handleInterrupt();
+    // }
+    //
+    // Rtc::initialise();
+    // Rtc::setSeconds(whenever);
+    // while (1) {
+    //     logSomething(Rtc::seconds());
+    //     Rtc::sleepUntilTick();
+    // }
+    //----------------------------------------------------------------------
+    namespace Rtc {
+
+        //------------------------------------------------------------------
+        // A number of seconds broken down into days and time of day.
+        //------------------------------------------------------------------
+        struct clockTime_t {
+            uint16_t days;
+            uint8_t hours;
+            uint8_t minutes;
+            uint8_t seconds;
+        };
+
+        struct state_t {
+            uint32_t seconds;               // Seconds since whenever you like.
+        };
+
+        typedef SeqCount<state_t> State;
+
+        //------------------------------------------------------------------
+        // Start Timer 2 from the crystal, or an external 32.768 KHz clock,
+        // with the overflow interrupt enabled. Interrupts need to be
+        // enabled, by you, for the clock to run.
+        //------------------------------------------------------------------
+        inline void initialise(const Timer2::asyncClock_t asyncClock = Timer2::ASYNC_CRYSTAL) {
+            State::data().seconds = 0;
+
+            Timer2::initialiseAsync(asyncClock,
+                                    Timer2::MODE_NORMAL,
+                                    Timer2::CLK_PRESCALE_128,
+                                    Timer2::OC2X_DISCONNECTED,
+                                    Timer2::INT_OVERFLOW);
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER2_OVF_vect).
+        //------------------------------------------------------------------
+        inline void handleInterrupt() {
+            State::data().seconds++;
+            State::changed();
+        }
+
+        //------------------------------------------------------------------
+        // Seconds since initialise(), or since whatever setSeconds() was
+        // given. Read twice if a tick arrives in the middle of reading.
+        //------------------------------------------------------------------
+        inline uint32_t seconds() {
+            uint32_t result;
+            uint8_t before;
+
+            do {
+                before = State::sequence();
+                result = State::data().seconds;
+            } while (State::changedSince(before));
+
+            return result;
+        }
+
+        //------------------------------------------------------------------
+        // Set the clock. The prescaler is reset as well, so the next tick
+        // is a whole second away.
+        //------------------------------------------------------------------
+        inline void setSeconds(const uint32_t newSeconds) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            TCNT2 = 0;
+            GTCCR |= (1 << PSRASY);
+            Timer2::waitForUpdate();
+
+            TIFR2 = (1 << TOV2);
+            State::data().seconds = newSeconds;
+
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Break a number of seconds down into days, hours, minutes and
+        // seconds.
+        //------------------------------------------------------------------
+        inline clockTime_t breakDown(uint32_t totalSeconds) {
+            clockTime_t time;
+
+            time.seconds = totalSeconds % 60;
+            totalSeconds /= 60;
+            time.minutes = totalSeconds % 60;
+            totalSeconds /= 60;
+            time.hours = totalSeconds % 24;
+            time.days = totalSeconds / 24;
+            return time;
+        }
+
+        inline clockTime_t now() {
+            return breakDown(seconds());
+        }
+
+        //------------------------------------------------------------------
+        // Sleep, in power save mode, until the next tick. Everything but
+        // Timer 2 and the watchdog stops, so it's microamps rather than
+        // milliamps. Other interrupts may wake the CPU early, if so, it
+        // goes straight back to sleep. Interrupts are enabled while asleep
+        // and put back as they were afterwards.
+        //
+        // Timer 2 needs a cycle of its slow clock after waking before the
+        // CPU sleeps again, see Timer2::waitForTimerClock(). That's done
+        // each time round.
+        //------------------------------------------------------------------
+        inline void sleepUntilTick() {
+            uint8_t oldSREG = SREG;
+            uint8_t before = State::sequence();
+
+            set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+            sleep_enable();
+
+            while (true) {
+                Timer2::waitForTimerClock();
+
+                cli();
+                if (State::changedSince(before)) {
+                    break;
+                }
+
+                sei();
+                sleep_cpu();
+            }
+
+            sleep_disable();
+            SREG = oldSREG;
+        }
+
+    }  // End of Rtc namespace.
+
+}  // End of AVRAssist namespace.
+
+#endif // __RTC_H__
@@ -0,0 +1,88 @@
+#ifndef __SEQCOUNT_H__
+#define __SEQCOUNT_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // State that an interrupt handler updates, and the main loop reads,
+    // without the main loop having to disable interrupts.
+    //
+    // The handler changes data(), then calls changed(), which adds one to
+    // an 8 bit change count. A reader notes sequence(), reads what it
+    // wants, then reads again if changedSince() says the handler ran in
+    // the middle. Provided the handler can't run 256 times during one
+    // read, which it can't if it's a timer tick, the read is consistent.
+    //
+    // There's one copy of the state for each Data type, see the Foibles
+    // chapter on header only state.
+    //
+    // Usage:
+    //
+    // struct state_t { uint32_t seconds; };
+    // typedef SeqCount<state_t> State;
+    //
+    // In the handler:
+    //
+    // State::data().seconds++;
+    // State::changed();
+    //
+    // In the main loop:
+    //
+    // uint32_t seconds;
+    // uint8_t before;
+    //
+    // do {
+    //     before = State::sequence();
+    //     seconds = State::data().seconds;
+    // } while (State::changedSince(before));
+    //----------------------------------------------------------------------
+    template <typename Data>
+    class SeqCount {
+    public:
+        static volatile Data &data() {
+            return storage().data;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from the interrupt handler, after changing data().
+        //------------------------------------------------------------------
+        static void changed() {
+            storage().ticks++;
+        }
+
+        static uint8_t sequence() {
+            return storage().ticks;
+        }
+
+        static bool changedSince(const uint8_t before) {
+            return storage().ticks != before;
+        }
+
+    private:
+        struct storage_t {
+            Data data;
+            uint8_t ticks;                  // Changes on every update.
+        };
+
+        static volatile storage_t &storage() {
+            static volatile storage_t values;
+            return values;
+        }
+    };
+
+}  // End of AVRAssist namespace.
+
+#endif // __SEQCOUNT_H__
@@ -0,0 +1,335 @@
+#ifndef __SERVO_H__
+#define __SERVO_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+#include "timer1.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Up to 12 hobby servos on any pins of ports B, C or D, driven by
+    // Timer 1.
+    //
+    // Timer 1 runs in CTC mode with TOP, in ICR1, at the end of the frame,
+    // usually 20 ms. Servos 0 to 5 are pulsed one after the other, each
+    // pulse ending as the next one starts, and so are servos 6 to 11, at
+    // the same time. The edges of the two sequences are handled in time
+    // order by the one compare match A interrupt, so one can never hold
+    // up the other.
+    //
+    // To keep the edges steady, even when other interrupts are running,
+    // the compare match is set a little early, SERVO_EARLY_US, and the
+    // handler then waits for TCNT1 to reach the exact time before
+    // changing the pins. Any edge due within that time of the last one
+    // is waited for in the same call. As long as nothing else holds the
+    // CPU for longer than SERVO_EARLY_US, the edges are exact to one
+    // Timer 1 count. The one exception is an edge of each sequence within
+    // a couple of microseconds of each other, the time it takes to change
+    // the pins, where the second is late by at most that.
+    //
+    // The waiting costs up to SERVO_EARLY_US of CPU time per edge. Each
+    // sequence has an edge per attached servo plus one to end it, so 14
+    // edges per frame with all 12 attached, around 224 us, or 1.1% of a
+    // 20 ms frame, before the handler's own time.
+    //
+    // Pulse widths are kept, in Timer 1 counts, in two copies per servo.
+    // write() fills in the copy not in use, then switches over with a
+    // single byte write, so the interrupt handler never sees half of a
+    // new 16 bit value, and nobody has to disable interrupts.
+    //
+    // Usage:
+    //
+    // typedef ServoController<> Servos;
+    // ISR(TIMER1_COMPA_vect) { Servos::handleInterrupt(); }
+    // ...
+    // Servos::attach(0, PORTB, (1 << PB1));
+    // Servos::initialise();
+    // sei();
+    // Servos::write(0, 1500);
+    //----------------------------------------------------------------------
+    const uint8_t SERVO_COUNT = 12;
+    const uint8_t SERVOS_PER_SEQUENCE = 6;
+
+    const uint16_t SERVO_MIN_US = 500;
+    const uint16_t SERVO_MAX_US = 2500;
+    const uint16_t SERVO_CENTRE_US = 1500;
+    const uint16_t SERVO_EARLY_US = 16;
+
+    //----------------------------------------------------------------------
+    // Microseconds to Timer 1 counts, with the prescaler at 8.
+    //----------------------------------------------------------------------
+    constexpr uint16_t servoCounts(const uint32_t micros) {
+        return micros * (F_CPU / 8 / 1000) / 1000;
+    }
+
+    template <uint16_t frameMicros = 20000>
+    class ServoController {
+    public:
+        static const uint16_t frameCounts = servoCounts(frameMicros);
+        static const uint16_t earlyCounts = servoCounts(SERVO_EARLY_US);
+
+        // The second sequence starts a little after the first, so their
+        // opening edges don't fall on the same count.
+        static const uint16_t startA = servoCounts(50);
+        static const uint16_t startB = servoCounts(100);
+
+        static_assert(startA > earlyCounts,
+                      "The first servo pulse starts too soon after the frame.");
+        static_assert(uint32_t(frameMicros) * (F_CPU / 8 / 1000) / 1000 <= 65535,
+                      "Servo frame is too long for Timer 1.");
+        static_assert(uint32_t(startB) + SERVOS_PER_SEQUENCE * uint32_t(servoCounts(SERVO_MAX_US)) + earlyCounts < frameCounts,
+                      "Servo frame is too short for six maximum width pulses.");
+
+        //------------------------------------------------------------------
+        // Give a servo a pin, PORTB, PORTC or PORTD and a bit mask, and
+        // make it an output. The pulse starts at SERVO_CENTRE_US.
+        //------------------------------------------------------------------
+        static void attach(const uint8_t servo, volatile uint8_t &port, const uint8_t mask) {
+            if (servo >= SERVO_COUNT) {
+                return;
+            }
+
+            uint8_t oldSREG = SREG;
+            cli();
+
+            port &= ~mask;
+            // DDRx is always the register just below PORTx.
+            *(&port - 1) |= mask;
+
+            ports[servo] = &port;
+            masks[servo] = mask;
+
+            SREG = oldSREG;
+            write(servo, SERVO_CENTRE_US);
+        }
+
+        //------------------------------------------------------------------
+        // Stop pulsing a servo. The pin is left low, if it was part way
+        // through a pulse, that pulse is cut short.
+        //------------------------------------------------------------------
+        static void detach(const uint8_t servo) {
+            if (servo >= SERVO_COUNT || !masks[servo]) {
+                return;
+            }
+
+            uint8_t oldSREG = SREG;
+            cli();
+            *ports[servo] &= ~masks[servo];
+            masks[servo] = 0;
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Start Timer 1. Attach the servos first, or at least before
+        // enabling interrupts.
+        //------------------------------------------------------------------
+        static void initialise() {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            for (uint8_t which = 0; which < 2; which++) {
+                sequences[which].target = which ? startB : startA;
+                sequences[which].ending = SERVO_COUNT;
+                sequences[which].starting = attached(which * SERVOS_PER_SEQUENCE, which);
+                sequences[which].nextFrame = false;
+            }
+
+            Timer1::queueICR1(frameCounts - 1);
+            Timer1::queueOCR1A(startA - earlyCounts);
+            Timer1::initialise(Timer1::MODE_CTC_ICR1,
+                               Timer1::CLK_PRESCALE_8,
+                               Timer1::OC1X_DISCONNECTED,
+                               Timer1::INT_COMP_MATCH_A);
+            TCNT1 = 0;
+            TIFR1 = (1 << OCF1A);
+
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Set a servo's pulse width, in microseconds. Clamped to between
+        // SERVO_MIN_US and SERVO_MAX_US. Used from the next pulse.
+        //------------------------------------------------------------------
+        static void write(const uint8_t servo, uint16_t micros) {
+            if (servo >= SERVO_COUNT) {
+                return;
+            }
+
+            if (micros < SERVO_MIN_US) {
+                micros = SERVO_MIN_US;
+            } else if (micros > SERVO_MAX_US) {
+                micros = SERVO_MAX_US;
+            }
+
+            uint8_t spare = current[servo] ^ 1;
+            widths[spare][servo] = servoCounts(micros);
+            __asm__ __volatile__ ("" ::: "memory");
+            current[servo] = spare;
+        }
+
+        //------------------------------------------------------------------
+        // The pulse width in microseconds.
+        //------------------------------------------------------------------
+        static uint16_t read(const uint8_t servo) {
+            if (servo >= SERVO_COUNT) {
+                return 0;
+            }
+
+            return uint32_t(widths[current[servo]][servo]) * 1000 / (F_CPU / 8 / 1000);
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER1_COMPA_vect). Interrupts are off in
+        // here, so the 16 bit writes are safe.
+        //------------------------------------------------------------------
+        static void handleInterrupt() {
+            // Both sequences waiting for the next frame, so this is it.
+            if (sequences[0].nextFrame && sequences[1].nextFrame) {
+                sequences[0].nextFrame = false;
+                sequences[1].nextFrame = false;
+            }
+
+            uint8_t which = earliest();
+
+            do {
+                sequence_t &state = sequences[which];
+                sequence_t &other = sequences[which ^ 1];
+
+                // Woken early, wait for the exact time.
+                while (TCNT1 < state.target) {
+                    ;
+                }
+
+                edge(state);
+
+                // If the other sequence's edge is close behind, do its
+                // pins too, before the slower work of finding the edges
+                // after. It's only late if it's closer than edge() takes.
+                if (!other.nextFrame && other.target - state.target < earlyCounts) {
+                    while (TCNT1 < other.target) {
+                        ;
+                    }
+
+                    edge(other);
+                    advance(other, which ^ 1);
+                }
+
+                advance(state, which);
+                which = earliest();
+
+                // Anything due before a compare match could be set up in
+                // time is done now, rather than missed.
+            } while (!sequences[which].nextFrame &&
+                     sequences[which].target <= uint32_t(TCNT1) + 2 * earlyCounts);
+
+            OCR1A = sequences[which].target - earlyCounts;
+        }
+
+    private:
+        struct sequence_t {
+            uint16_t target;                // Exact time of the next edge.
+            uint8_t ending;                 // Servo whose pulse ends then, or SERVO_COUNT.
+            uint8_t starting;               // Servo whose pulse starts then, or SERVO_COUNT.
+            bool nextFrame;                 // The next edge is in the next frame.
+        };
+
+        //------------------------------------------------------------------
+        // The first attached servo from 'servo' to the end of sequence
+        // 'which', or SERVO_COUNT.
+        //------------------------------------------------------------------
+        static uint8_t attached(uint8_t servo, const uint8_t which) {
+            const uint8_t last = (which + 1) * SERVOS_PER_SEQUENCE;
+
+            while (servo < last && !masks[servo]) {
+                servo++;
+            }
+
+            return servo < last ? servo : SERVO_COUNT;
+        }
+
+        //------------------------------------------------------------------
+        // Which sequence has the next edge. One still in this frame comes
+        // before one waiting for the next.
+        //------------------------------------------------------------------
+        static uint8_t earliest() {
+            if (sequences[0].nextFrame != sequences[1].nextFrame) {
+                return sequences[0].nextFrame ? 1 : 0;
+            }
+
+            return sequences[0].target <= sequences[1].target ? 0 : 1;
+        }
+
+        //------------------------------------------------------------------
+        // One edge: the last servo's pulse ends, and the next one's starts.
+        // Only the pins are changed here, so that it's quick, and two
+        // edges on the same count are as close together as they can be.
+        //------------------------------------------------------------------
+        static void edge(const sequence_t &state) {
+            if (state.ending < SERVO_COUNT) {
+                *ports[state.ending] &= ~masks[state.ending];
+            }
+
+            if (state.starting < SERVO_COUNT) {
+                *ports[state.starting] |= masks[state.starting];
+            }
+        }
+
+        //------------------------------------------------------------------
+        // Work out the edge after. The shortest pulse is far longer than
+        // SERVO_EARLY_US plus the time in here, so it's never already past.
+        //------------------------------------------------------------------
+        static void advance(sequence_t &state, const uint8_t which) {
+            uint8_t servo = state.starting;
+
+            if (servo < SERVO_COUNT) {
+                state.target += widths[current[servo]][servo];
+                state.ending = servo;
+                state.starting = attached(servo + 1, which);
+            } else {
+                // End of the sequence, wait for the next frame.
+                state.target = which ? startB : startA;
+                state.ending = SERVO_COUNT;
+                state.starting = attached(which * SERVOS_PER_SEQUENCE, which);
+                state.nextFrame = true;
+            }
+        }
+
+        static volatile uint8_t *ports[SERVO_COUNT];
+        static uint8_t masks[SERVO_COUNT];
+        static uint16_t widths[2][SERVO_COUNT];
+        static volatile uint8_t current[SERVO_COUNT];
+        static sequence_t sequences[2];
+    };
+
+    template <uint16_t frameMicros>
+    volatile uint8_t *ServoController<frameMicros>::ports[SERVO_COUNT];
+
+    template <uint16_t frameMicros>
+    uint8_t ServoController<frameMicros>::masks[SERVO_COUNT];
+
+    template <uint16_t frameMicros>
+    uint16_t ServoController<frameMicros>::widths[2][SERVO_COUNT];
+
+    template <uint16_t frameMicros>
+    volatile uint8_t ServoController<frameMicros>::current[SERVO_COUNT];
+
+    template <uint16_t frameMicros>
+    typename ServoController<frameMicros>::sequence_t ServoController<frameMicros>::sequences[2];
+
+}  // End of AVRAssist namespace.
+
+#endif // __SERVO_H__
@@ -0,0 +1,344 @@
+#ifndef __SOFTPWM_H__
+#define __SOFTPWM_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+#include "timer1.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // A hand estimate of the worst case cycles for handleInterrupt(), with
+    // all three ports in use and the table swap at the start of a period.
+    // It hasn't been taken from compiler output or timed on hardware, the
+    // instructions were written out by hand, as avr-gcc might compile
+    // them, and added up:
+    //
+    //  7 cycles  interrupt response and the jmp in the vector table.
+    //  4 cycles  at most, finishing the instruction running at the time.
+    // 23 cycles  prologue, SREG, r0, r1 and six registers saved.
+    // 31 cycles  finding the edge and writing PORTB, PORTC and PORTD.
+    // 31 cycles  last edge, table swap and OCR1A = 0.
+    // 22 cycles  epilogue and reti.
+    //
+    // That's 118, rounded up to 120. The real figure depends on the
+    // compiler and its options, so before relying on it, count the
+    // vector's instructions in the avr-objdump -d listing of your build,
+    // or toggle a pin around the handler and time it. The static_assert
+    // in SoftPwm, that no step is shorter than this, is only as good as
+    // the estimate.
+    //----------------------------------------------------------------------
+    const uint16_t SOFTPWM_ISR_CYCLES = 120;
+
+    //----------------------------------------------------------------------
+    // Number of bits set in a port mask.
+    //----------------------------------------------------------------------
+    constexpr uint8_t softPwmBits(const uint8_t mask) {
+        return mask ? (mask & 1) + softPwmBits(mask >> 1) : 0;
+    }
+
+    //----------------------------------------------------------------------
+    // The smallest Timer 1 prescaler that fits a whole period of 256
+    // steps into 16 bits. CLK_DISABLED if none does.
+    //----------------------------------------------------------------------
+    constexpr uint8_t softPwmSource(const uint32_t cyclesPerStep,
+                                    const uint8_t clockSource = Timer1::CLK_PRESCALE_1) {
+        return clockSource > Timer1::CLK_PRESCALE_1024 ? uint8_t(Timer1::CLK_DISABLED) :
+               cyclesPerStep / Timer1::prescaleDivisor(clockSource) <= 256
+               ? clockSource
+               : softPwmSource(cyclesPerStep, clockSource + 1);
+    }
+
+    //----------------------------------------------------------------------
+    // Software PWM on up to 24 pins of ports B, C and D, driven by the
+    // Timer 1 compare match A interrupt.
+    //
+    // Duty cycles are 0 to 255, as for analogWrite(), 0 is always off and
+    // 255 always on. Every pin goes high at the start of the period and
+    // each goes low at its own step. Rather than interrupting on every
+    // one of the 256 steps, the edges are sorted into a table, pins with
+    // the same duty cycle sharing an edge, and the interrupt only comes
+    // at each edge, setting a whole port with a single write each time.
+    //
+    // The table is worked out in the main loop, by update(), into a
+    // second copy which the ISR swaps to at the start of the next period,
+    // so a period is never a mix of old and new duty cycles.
+    //
+    // Channels are numbered from the lowest bit of maskB, then maskC,
+    // then maskD.
+    //
+    // Usage:
+    //
+    // typedef SoftPwm<200, 0x0F, 0x00, 0xF0> Leds;    // 200 Hz, 8 pins.
+    // ISR(TIMER1_COMPA_vect) { Leds::handleInterrupt(); }
+    // ...
+    // Leds::initialise();
+    // sei();
+    // Leds::set(0, 128);
+    // Leds::set(5, 10);
+    // Leds::update();
+    //----------------------------------------------------------------------
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC = 0, uint8_t maskD = 0>
+    class SoftPwm {
+    public:
+        static const uint8_t channelCount = softPwmBits(maskB) + softPwmBits(maskC) + softPwmBits(maskD);
+        static const uint32_t cyclesPerStep = F_CPU / (256UL * frequency);
+        static const uint8_t clockSource = softPwmSource(cyclesPerStep);
+        static const uint16_t ticksPerStep = cyclesPerStep / Timer1::prescaleDivisor(clockSource);
+
+        static_assert(channelCount >= 1 && channelCount <= 24,
+                      "SoftPwm needs 1 to 24 channels.");
+        static_assert(clockSource != Timer1::CLK_DISABLED,
+                      "SoftPwm frequency is too low for Timer 1.");
+        static_assert(uint32_t(ticksPerStep) * Timer1::prescaleDivisor(clockSource) >= SOFTPWM_ISR_CYCLES,
+                      "SoftPwm frequency is too high, the steps are shorter than the ISR.");
+
+        //------------------------------------------------------------------
+        // Make the pins outputs, all off, and start Timer 1 in CTC mode
+        // with TOP, in ICR1, at the end of the 256th step. Interrupts need
+        // to be enabled, by you, to start things off.
+        //------------------------------------------------------------------
+        static void initialise() {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            PORTB &= ~maskB;
+            PORTC &= ~maskC;
+            PORTD &= ~maskD;
+            DDRB |= maskB;
+            DDRC |= maskC;
+            DDRD |= maskD;
+
+            for (uint8_t channel = 0; channel < channelCount; channel++) {
+                duty[channel] = 0;
+            }
+
+            build(tables[0]);
+            active = tables[0];
+            spare = tables[1];
+            next = 0;
+            swapPending = false;
+
+            // Set up with the clock stopped, then start it from TOP. A
+            // write to TCNT1 blocks any compare match on the next timer
+            // clock, so starting from 0 would miss the first edge, at 0.
+            // From TOP, the next clock only takes it to 0, and the edge
+            // at 0 comes on the clock after.
+            Timer1::queueICR1(256U * ticksPerStep - 1);
+            Timer1::queueOCR1A(0);
+            Timer1::initialise(Timer1::MODE_CTC_ICR1,
+                               Timer1::CLK_DISABLED,
+                               Timer1::OC1X_DISCONNECTED,
+                               Timer1::INT_COMP_MATCH_A);
+            TCNT1 = 256U * ticksPerStep - 1;
+            TIFR1 = (1 << OCF1A);
+            TCCR1B |= clockSource;
+
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // Set a channel's duty cycle. Nothing changes until update().
+        //------------------------------------------------------------------
+        static void set(const uint8_t channel, const uint8_t dutyCycle) {
+            if (channel < channelCount) {
+                duty[channel] = dutyCycle;
+            }
+        }
+
+        static uint8_t get(const uint8_t channel) {
+            return channel < channelCount ? duty[channel] : 0;
+        }
+
+        //------------------------------------------------------------------
+        // Sort the duty cycles into a new edge table, to be used from the
+        // start of the next period. If the last update() hasn't been
+        // picked up yet, this waits for it, at most one period, so don't
+        // call it with interrupts off.
+        //------------------------------------------------------------------
+        static void update() {
+            while (swapPending) {
+                ;
+            }
+
+            build(spare);
+            __asm__ __volatile__ ("" ::: "memory");
+            swapPending = true;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER1_COMPA_vect). Each call sets the pins
+        // for one edge and points OCR1A at the next.
+        //------------------------------------------------------------------
+        static void handleInterrupt() {
+            const edge_t *edge = active + next;
+
+            if (maskB) {
+                PORTB = (PORTB & ~maskB) | edge->portB;
+            }
+
+            if (maskC) {
+                PORTC = (PORTC & ~maskC) | edge->portC;
+            }
+
+            if (maskD) {
+                PORTD = (PORTD & ~maskD) | edge->portD;
+            }
+
+            if (edge->last) {
+                next = 0;
+
+                // Start of a new period, the only safe time to swap.
+                if (swapPending) {
+                    edge_t *table = active;
+                    active = spare;
+                    spare = table;
+                    swapPending = false;
+                }
+
+                OCR1A = 0;
+            } else {
+                next++;
+                OCR1A = edge[1].time;
+            }
+        }
+
+    private:
+        //------------------------------------------------------------------
+        // One edge. The port values are those of the pins from this edge
+        // on. The first edge is always at time 0.
+        //------------------------------------------------------------------
+        struct edge_t {
+            uint16_t time;                  // Timer 1 count.
+            uint8_t portB;
+            uint8_t portC;
+            uint8_t portD;
+            bool last;                      // Last edge of the period.
+        };
+
+        //------------------------------------------------------------------
+        // Which port, and which bit of it, a channel is.
+        //------------------------------------------------------------------
+        static void channelBit(const uint8_t channel, uint8_t &port, uint8_t &bit) {
+            uint8_t count = channel;
+            const uint8_t masks[3] = { maskB, maskC, maskD };
+
+            for (port = 0; port < 3; port++) {
+                for (uint8_t test = 1; test; test <<= 1) {
+                    if (masks[port] & test) {
+                        if (!count--) {
+                            bit = test;
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+
+        //------------------------------------------------------------------
+        // Build an edge table from the duty cycles. An insertion sort, as
+        // there are only a few channels. Anything 0 or 255 never has an
+        // edge of its own.
+        //------------------------------------------------------------------
+        static void build(edge_t *table) {
+            uint8_t order[channelCount];
+            uint8_t sorted = 0;
+
+            for (uint8_t channel = 0; channel < channelCount; channel++) {
+                uint8_t position = sorted++;
+
+                while (position && duty[order[position - 1]] > duty[channel]) {
+                    order[position] = order[position - 1];
+                    position--;
+                }
+
+                order[position] = channel;
+            }
+
+            // Everything not at 0% starts high.
+            uint8_t state[3] = { 0, 0, 0 };
+
+            for (uint8_t channel = 0; channel < channelCount; channel++) {
+                if (duty[channel]) {
+                    uint8_t port, bit;
+                    channelBit(channel, port, bit);
+                    state[port] |= bit;
+                }
+            }
+
+            uint8_t edges = 0;
+            setEdge(table[edges++], 0, state);
+
+            // Then each goes low at its own step, same steps sharing an edge.
+            for (uint8_t index = 0; index < channelCount; index++) {
+                uint8_t step = duty[order[index]];
+
+                if (step == 0 || step == 255) {
+                    continue;
+                }
+
+                uint8_t port, bit;
+                channelBit(order[index], port, bit);
+                state[port] &= ~bit;
+
+                if (index + 1 < channelCount && duty[order[index + 1]] == step) {
+                    continue;
+                }
+
+                setEdge(table[edges++], step * ticksPerStep, state);
+            }
+
+            table[edges - 1].last = true;
+        }
+
+        static void setEdge(edge_t &edge, const uint16_t time, const uint8_t *state) {
+            edge.time = time;
+            edge.portB = state[0];
+            edge.portC = state[1];
+            edge.portD = state[2];
+            edge.last = false;
+        }
+
+        static uint8_t duty[channelCount];
+        static edge_t tables[2][channelCount + 1];
+        static edge_t *volatile active;     // Being used by the ISR.
+        static edge_t *volatile spare;      // Being built by update().
+        static uint8_t next;                // Index of the next edge.
+        static volatile bool swapPending;
+    };
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    uint8_t SoftPwm<frequency, maskB, maskC, maskD>::duty[SoftPwm<frequency, maskB, maskC, maskD>::channelCount];
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    typename SoftPwm<frequency, maskB, maskC, maskD>::edge_t
+        SoftPwm<frequency, maskB, maskC, maskD>::tables[2][SoftPwm<frequency, maskB, maskC, maskD>::channelCount + 1];
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    typename SoftPwm<frequency, maskB, maskC, maskD>::edge_t *volatile SoftPwm<frequency, maskB, maskC, maskD>::active;
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    typename SoftPwm<frequency, maskB, maskC, maskD>::edge_t *volatile SoftPwm<frequency, maskB, maskC, maskD>::spare;
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    uint8_t SoftPwm<frequency, maskB, maskC, maskD>::next;
+
+    template <uint32_t frequency, uint8_t maskB, uint8_t maskC, uint8_t maskD>
+    volatile bool SoftPwm<frequency, maskB, maskC, maskD>::swapPending;
+
+}  // End of AVRAssist namespace.
+
+#endif // __SOFTPWM_H__
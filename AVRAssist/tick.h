@@ -0,0 +1,180 @@
+#ifndef __TICK_H__
+#define __TICK_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include "seqcount.h"
+#include "timer2.h"
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // A millisecond tick, on Timer 2 in CTC mode, for those times when
+    // the Arduino's Timer 0 millis() isn't there, or is in the way.
+    //
+    // Usage:
+    //
+    // ISR(TIMER2_COMPA_vect) {
+    //     Tick::handleInterrupt();
+    // }
+    //
+    // Tick::initialise();
+    // sei();
+    // ...
+    // uint32_t now = Tick::millis();
+    //----------------------------------------------------------------------
+    namespace Tick {
+
+        //------------------------------------------------------------------
+        // The nearest Timer 2 setting to 1 ms. The tolerance is wide open
+        // as any error is corrected for below.
+        //------------------------------------------------------------------
+        typedef Timer2::Period<F_CPU, 1000, 1000000> Solver;
+
+        //------------------------------------------------------------------
+        // CPU cycles per tick and per Timer 2 count. If a tick is exactly
+        // one millisecond, the interrupt handler only has to count. If
+        // not, it has to keep track of the fraction of a millisecond left
+        // over as well.
+        //------------------------------------------------------------------
+        const uint32_t CYCLES_PER_COUNT = Timer2::prescaleDivisor(Solver::clockSource);
+        const uint32_t CYCLES_PER_TICK = (uint32_t(Solver::top) + 1) * CYCLES_PER_COUNT;
+        const bool EXACT = uint64_t(CYCLES_PER_TICK) * 1000 == F_CPU;
+
+        static_assert(uint64_t(CYCLES_PER_TICK) * 1000 < 0x80000000UL,
+                      "F_CPU is too high for the tick fraction to fit.");
+
+        //------------------------------------------------------------------
+        // The fraction is in units of 1/1000 of a CPU cycle, so that one
+        // millisecond is exactly F_CPU units, whatever F_CPU is.
+        //------------------------------------------------------------------
+        struct state_t {
+            uint32_t milliseconds;          // Whole milliseconds so far.
+            uint32_t fraction;              // Part millisecond, EXACT false only.
+        };
+
+        typedef SeqCount<state_t> State;
+
+        //------------------------------------------------------------------
+        // Start the tick. Timer 2 is taken over completely, so PWM on
+        // OC2A and OC2B, and the Arduino tone(), can't be used as well.
+        // Interrupts need to be enabled, by you, for the tick to run.
+        //------------------------------------------------------------------
+        inline void initialise() {
+            State::data().milliseconds = 0;
+            State::data().fraction = 0;
+
+            Timer2::initialise(Timer2::MODE_CTC_OCR2A,
+                               Solver::clockSource,
+                               Timer2::OC2X_DISCONNECTED,
+                               Timer2::INT_COMPARE_MATCH_A);
+            OCR2A = Solver::top;
+            TCNT2 = 0;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from ISR(TIMER2_COMPA_vect). When EXACT, this is a
+        // 32 bit increment and an 8 bit one, and nothing else.
+        //------------------------------------------------------------------
+        inline void handleInterrupt() {
+            volatile state_t &clock = State::data();
+
+            if (EXACT) {
+                clock.milliseconds++;
+            } else {
+                uint32_t fraction = clock.fraction + CYCLES_PER_TICK * 1000;
+                uint32_t milliseconds = clock.milliseconds;
+
+                while (fraction >= F_CPU) {
+                    fraction -= F_CPU;
+                    milliseconds++;
+                }
+
+                clock.fraction = fraction;
+                clock.milliseconds = milliseconds;
+            }
+
+            State::changed();
+        }
+
+        //------------------------------------------------------------------
+        // Milliseconds since initialise(). Interrupts are left alone, so
+        // the read is repeated if a tick arrives in the middle of it.
+        // Wraps after about 49 days.
+        //------------------------------------------------------------------
+        inline uint32_t millis() {
+            uint32_t milliseconds;
+            uint8_t before;
+
+            do {
+                before = State::sequence();
+                milliseconds = State::data().milliseconds;
+            } while (State::changedSince(before));
+
+            return milliseconds;
+        }
+
+        //------------------------------------------------------------------
+        // Microseconds since initialise(). The resolution is one Timer 2
+        // count, 4 us at 16 MHz. Wraps after about 71 minutes.
+        //
+        // If interrupts are off, a tick may be pending but not counted
+        // yet. OCF2A is set when TCNT2 reaches TOP, so if it's set and
+        // TCNT2 has since wrapped, that tick is added in here.
+        //------------------------------------------------------------------
+        inline uint32_t micros() {
+            volatile state_t &clock = State::data();
+            uint32_t milliseconds;
+            uint32_t fraction;
+            uint8_t count;
+            bool pending;
+            uint8_t before;
+
+            do {
+                before = State::sequence();
+                milliseconds = clock.milliseconds;
+                fraction = EXACT ? 0 : clock.fraction;
+                count = TCNT2;
+                pending = (TIFR2 & (1 << OCF2A)) && (count < Solver::top);
+            } while (State::changedSince(before));
+
+            if (EXACT) {
+                if (pending) {
+                    milliseconds++;
+                }
+
+                // Nothing here but constants, so 1000 / (top + 1) folds
+                // away when it divides exactly, as it does for the
+                // usual clocks.
+                return milliseconds * 1000 +
+                       ((1000 % (uint16_t(Solver::top) + 1)) == 0
+                        ? count * (1000 / (uint16_t(Solver::top) + 1))
+                        : uint16_t(uint32_t(count) * 1000 / (uint16_t(Solver::top) + 1)));
+            }
+
+            // CPU cycles since the last whole millisecond.
+            uint32_t cycles = fraction / 1000 + count * CYCLES_PER_COUNT;
+
+            if (pending) {
+                cycles += CYCLES_PER_TICK;
+            }
+
+            return milliseconds * 1000 + cycles * 1000 / (F_CPU / 1000);
+        }
+
+    }  // End of Tick namespace.
+
+}  // End of AVRAssist namespace.
+
+#endif // __TICK_H__
@@ -0,0 +1,331 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+#include "timer0.h"
+#include "timer1.h"
+#include "timer2.h"
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Compile time timer configuration. Everything that initialise()
+    // checks at run time, and silently returns on, is checked here with
+    // static_assert instead. apply() is nothing but constant stores to the
+    // timer's registers.
+    //
+    // Usage:
+    //
+    // typedef Timer<1>::Config<Timer1::MODE_CTC_OCR1A,
+    //                          Timer1::CLK_PRESCALE_256,
+    //                          Timer1::OC1A_TOGGLE> Blink;
+    // Blink::apply();
+    //
+    // Compare match and interrupt values may be OR'd together as usual.
+    //----------------------------------------------------------------------
+    template <uint8_t timerNumber>
+    struct Timer {
+        static_assert(timerNumber <= 2, "There are only Timers 0, 1 and 2.");
+    };
+
+
+    //----------------------------------------------------------------------
+    // Timer 0.
+    //----------------------------------------------------------------------
+    template <>
+    struct Timer<0> {
+
+        template <uint8_t timerMode,
+                  Timer0::clockSource_t clockSource,
+                  uint8_t compareMatch = Timer0::OCOX_DISCONNECTED,
+                  uint8_t enableInterrupts = Timer0::INT_NONE>
+        struct Config {
+            static_assert(timerMode <= Timer0::MODE_FAST_PWM_OCR0A &&
+                          timerMode != Timer0::MODE_RESERVED_4 &&
+                          timerMode != Timer0::MODE_RESERVED_6,
+                          "Timer 0 mode is reserved or invalid.");
+
+            static_assert(!(compareMatch & ~(Timer0::OCOA_SET | Timer0::OCOB_SET)),
+                          "Timer 0 compare match has unknown bits set.");
+
+            static_assert((compareMatch & Timer0::OCOB_SET) != Timer0::OCOB_TOGGLE ||
+                          timerMode == Timer0::MODE_NORMAL ||
+                          timerMode == Timer0::MODE_CTC_OCR0A,
+                          "Timer 0 OC0B can only toggle in NORMAL and CTC modes.");
+
+            static_assert(!(enableInterrupts & ~(Timer0::INT_COMPARE_MATCH_A |
+                                                 Timer0::INT_COMPARE_MATCH_B |
+                                                 Timer0::INT_OVERFLOW)),
+                          "Timer 0 interrupts have unknown bits set.");
+
+            static constexpr uint8_t tccrA = Timer0::modeBitsA(timerMode) | compareMatch;
+            static constexpr uint8_t tccrB = Timer0::modeBitsB(timerMode) | clockSource;
+            static constexpr uint8_t timsk = enableInterrupts;
+
+            static constexpr uint8_t prescalerReset = (1 << PSRSYNC);
+            // Only a divided clock goes through the prescaler, so only
+            // that is halted by holding PSRSYNC.
+            static constexpr bool prescaled = clockSource >= Timer0::CLK_PRESCALE_8 && clockSource <= Timer0::CLK_PRESCALE_1024;
+
+            static void apply() {
+                TCCR0A = tccrA;
+                TCCR0B = tccrB;
+                TIMSK0 = timsk;
+            }
+
+            static void preload(const uint8_t count) {
+                TCNT0 = count;
+            }
+        };
+    };
+
+
+    //----------------------------------------------------------------------
+    // Timer 1.
+    //----------------------------------------------------------------------
+    template <>
+    struct Timer<1> {
+
+        template <uint8_t timerMode,
+                  Timer1::clockSource_t clockSource,
+                  uint8_t compareMatch = Timer1::OC1X_DISCONNECTED,
+                  uint8_t enableInterrupts = Timer1::INT_NONE,
+                  uint8_t inputCapture = Timer1::INPCAP_NOISE_CANCEL_OFF_FALLING_EDGE>
+        struct Config {
+            static_assert(timerMode <= Timer1::MODE_FAST_PWM_OCR1A &&
+                          timerMode != Timer1::MODE_RESERVED_13,
+                          "Timer 1 mode is reserved or invalid.");
+
+            static_assert(!(compareMatch & ~(Timer1::OC1A_SET | Timer1::OC1B_SET)),
+                          "Timer 1 compare match has unknown bits set.");
+
+            static_assert((compareMatch & Timer1::OC1B_SET) != Timer1::OC1B_TOGGLE ||
+                          timerMode == Timer1::MODE_NORMAL ||
+                          timerMode == Timer1::MODE_CTC_OCR1A ||
+                          timerMode == Timer1::MODE_CTC_ICR1,
+                          "Timer 1 OC1B can only toggle in NORMAL and CTC modes.");
+
+            static_assert(!(enableInterrupts & ~(Timer1::INT_CAPTURE |
+                                                 Timer1::INT_COMP_MATCH_A |
+                                                 Timer1::INT_COMP_MATCH_B |
+                                                 Timer1::INT_OVERFLOW)),
+                          "Timer 1 interrupts have unknown bits set.");
+
+            static_assert(!(inputCapture & ~Timer1::INPCAP_NOISE_CANCEL_ON_RISING_EDGE),
+                          "Timer 1 input capture has unknown bits set.");
+
+            static constexpr uint8_t tccrA = Timer1::modeBitsA(timerMode) | compareMatch;
+            static constexpr uint8_t tccrB = Timer1::modeBitsB(timerMode) | clockSource | inputCapture;
+            static constexpr uint8_t timsk = enableInterrupts;
+
+            static constexpr uint8_t prescalerReset = (1 << PSRSYNC);
+            // Only a divided clock goes through the prescaler, so only
+            // that is halted by holding PSRSYNC.
+            static constexpr bool prescaled = clockSource >= Timer1::CLK_PRESCALE_8 && clockSource <= Timer1::CLK_PRESCALE_1024;
+
+            static void apply() {
+                TCCR1A = tccrA;
+                TCCR1B = tccrB;
+                TCCR1C = 0;
+                TIMSK1 = timsk;
+
+                // As initialise(), anything queued is written now.
+                if (Timer1::queue().pending) {
+                    Timer1::applyQueued();
+                }
+            }
+
+            static void preload(const uint16_t count) {
+                Timer1::writeTCNT1(count);
+            }
+        };
+    };
+
+
+    //----------------------------------------------------------------------
+    // Timer 2.
+    //----------------------------------------------------------------------
+    template <>
+    struct Timer<2> {
+
+        template <uint8_t timerMode,
+                  Timer2::clockSource_t clockSource,
+                  uint8_t compareMatch = Timer2::OC2X_DISCONNECTED,
+                  uint8_t enableInterrupts = Timer2::INT_NONE>
+        struct Config {
+            static_assert(timerMode <= Timer2::MODE_FAST_PWM_OCR2A &&
+                          timerMode != Timer2::MODE_RESERVED_4 &&
+                          timerMode != Timer2::MODE_RESERVED_6,
+                          "Timer 2 mode is reserved or invalid.");
+
+            static_assert(!(compareMatch & ~(Timer2::OC2A_SET | Timer2::OC2B_SET)),
+                          "Timer 2 compare match has unknown bits set.");
+
+            static_assert((compareMatch & Timer2::OC2B_SET) != Timer2::OC2B_TOGGLE ||
+                          timerMode == Timer2::MODE_NORMAL ||
+                          timerMode == Timer2::MODE_CTC_OCR2A,
+                          "Timer 2 OC2B can only toggle in NORMAL and CTC modes.");
+
+            static_assert(!(enableInterrupts & ~(Timer2::INT_COMPARE_MATCH_A |
+                                                 Timer2::INT_COMPARE_MATCH_B |
+                                                 Timer2::INT_OVERFLOW)),
+                          "Timer 2 interrupts have unknown bits set.");
+
+            static constexpr uint8_t tccrA = Timer2::modeBitsA(timerMode) | compareMatch;
+            static constexpr uint8_t tccrB = Timer2::modeBitsB(timerMode) | clockSource;
+            static constexpr uint8_t timsk = enableInterrupts;
+
+            static constexpr uint8_t prescalerReset = (1 << PSRASY);
+            // Only a divided clock goes through the prescaler, so only
+            // that is halted by holding PSRASY.
+            static constexpr bool prescaled = clockSource >= Timer2::CLK_PRESCALE_8;
+
+            static void apply() {
+                TCCR2A = tccrA;
+                TCCR2B = tccrB;
+                TIMSK2 = timsk;
+            }
+
+            static void preload(const uint8_t count) {
+                TCNT2 = count;
+            }
+        };
+    };
+
+
+    //----------------------------------------------------------------------
+    // Starting timers in step.
+    //
+    // Each timer starts counting as soon as its clock source is set, so
+    // timers set up one after the other start a few cycles apart, and
+    // their prescalers are wherever they happen to be. Setting TSM in
+    // GTCCR holds the prescaler resets, PSRSYNC for Timers 0 and 1, and
+    // PSRASY for Timer 2, halting those timers while they're set up and
+    // their TCNTn preloaded. Clearing TSM then lets them all go on the
+    // same clock cycle, with their prescalers at zero.
+    //
+    // Only timers on a divided clock, CLK_PRESCALE_8 and up, are halted.
+    // CLK_PRESCALE_1 bypasses the prescaler, as do the external T0 and
+    // T1 pins, so those timers start counting in their own initialise()
+    // and are never in step.
+    //
+    // Usage:
+    //
+    // Timers::halt();
+    // Timer0::initialise(..., Timer0::CLK_PRESCALE_8, ...);
+    // Timer2::initialise(..., Timer2::CLK_PRESCALE_8, ...);
+    // TCNT0 = 0;
+    // TCNT2 = 128;                         // Half a period behind.
+    // Timers::release();
+    //
+    // Or, with the compile time configurations above, all from zero:
+    //
+    // Timers::startTogether<PhaseA, PhaseB>();
+    //----------------------------------------------------------------------
+    namespace Timers {
+
+        //------------------------------------------------------------------
+        // PRESCALERS to hold. These end up in GTCCR, with TSM.
+        //------------------------------------------------------------------
+        enum prescalerReset_t : uint8_t {
+            PRESCALER_SYNC = (1 << PSRSYNC),        // Timers 0 and 1.
+            PRESCALER_ASYNC = (1 << PSRASY),        // Timer 2.
+            PRESCALER_ALL = (1 << PSRSYNC) | (1 << PSRASY)
+        };
+
+        //------------------------------------------------------------------
+        // Halt the timers on the given prescalers. They stay halted,
+        // whatever is written to their registers, until release(). A
+        // timer on CLK_PRESCALE_1, or an external clock, doesn't use the
+        // prescaler and keeps running regardless.
+        //------------------------------------------------------------------
+        inline void halt(const prescalerReset_t prescalers = PRESCALER_ALL) {
+            GTCCR = (1 << TSM) | prescalers;
+        }
+
+        //------------------------------------------------------------------
+        // Start everything halted, in the same cycle. Clearing TSM lets
+        // the hardware clear PSRSYNC and PSRASY.
+        //------------------------------------------------------------------
+        inline void release() {
+            GTCCR = 0;
+        }
+
+        //------------------------------------------------------------------
+        // The prescalers used by a list of Timer<N>::Config types, so that
+        // startTogether() leaves any others alone.
+        //------------------------------------------------------------------
+        template <typename Only>
+        constexpr uint8_t prescalersOf() {
+            return Only::prescalerReset;
+        }
+
+        template <typename First, typename Second, typename... Rest>
+        constexpr uint8_t prescalersOf() {
+            return First::prescalerReset | prescalersOf<Second, Rest...>();
+        }
+
+        //------------------------------------------------------------------
+        // Are all of a list of Timer<N>::Config types on a divided clock,
+        // which halt() can actually stop?
+        //------------------------------------------------------------------
+        template <typename Only>
+        constexpr bool allPrescaled() {
+            return Only::prescaled;
+        }
+
+        template <typename First, typename Second, typename... Rest>
+        constexpr bool allPrescaled() {
+            return First::prescaled && allPrescaled<Second, Rest...>();
+        }
+
+        template <typename Only>
+        inline void applyEach() {
+            Only::apply();
+            Only::preload(0);
+        }
+
+        template <typename First, typename Second, typename... Rest>
+        inline void applyEach() {
+            applyEach<First>();
+            applyEach<Second, Rest...>();
+        }
+
+        //------------------------------------------------------------------
+        // Halt, apply() each configuration, zero each TCNTn, and release,
+        // so all the timers start from BOTTOM together. Interrupts are off
+        // throughout.
+        //------------------------------------------------------------------
+        template <typename... Configs>
+        inline void startTogether() {
+            static_assert(allPrescaled<Configs...>(),
+                          "startTogether() needs CLK_PRESCALE_8 or slower, CLK_PRESCALE_1 and external clocks can't be halted.");
+
+            uint8_t oldSREG = SREG;
+            cli();
+
+            halt(prescalerReset_t(prescalersOf<Configs...>()));
+            applyEach<Configs...>();
+            release();
+
+            SREG = oldSREG;
+        }
+
+    }  // End of Timers namespace.
+
+}  // End of AVRAssist namespace.
+
+#endif // __TIMER_H__
@@ -13,6 +13,8 @@
     #include <avr/io.h>
 #endif
 
+#include "timersolver.h"
+
 namespace AVRAssist {
     
     //----------------------------------------------------------------------
@@ -22,7 +24,7 @@ namespace AVRAssist {
         
         //------------------------------------------------------------------
         // TIMER MODES. Modes 4 and 6 are reserved and not used. The rest
-        // are simply used to index into the timerModes[][] array below.
+        // are the values of the WGM bits, see modeBitsA() and modeBitsB().
         //------------------------------------------------------------------
         enum  : uint8_t {
             MODE_NORMAL = 0,                        // Mode 0: Normal mode.
@@ -36,22 +38,19 @@ namespace AVRAssist {
         };
 
         //------------------------------------------------------------------
-        // TCCR0A and TCCR0B initial settings for the various timer modes. 
-        // TCCR0A is index [n][0]
-        // TCCR0B is index [n][1]
-        // These bits end up in WGM01 & WGM00 in TCCR0A and WGM02 in TCCR0B
-        // depending on the timer mode chosen from the above.
-        //------------------------------------------------------------------
-        const uint8_t timerModes[8][2] = {          // [n][0] = TCCR0A, [n][1] = TCCR0B
-            {0, 0},                                 // Normal, TOP = 255
-            {(1 << WGM00), 0},                      // Phase Correct PWM, TOP = 255
-            {(1 << WGM01), 0},                      // Clear Timer on Compare, TOP = OCR0A
-            {((1 << WGM00) | (1 << WGM01)), 0},     // Fast PWM, TOP = 255
-            {0, (1 << WGM02)},                      // Reserved - don't use
-            {((1 << WGM00), (1 << WGM02))},         // PWM - Phase-correct, TOP = OCR0A
-            {((1 << WGM01), (1 << WGM02))},         // Reserved - don't use
-            {((1 << WGM00) | (1 << WGM01), (1 << WGM02))}     // Fast PWM, TOP = OCR0A
-        };
+        // WGM bits for the various timer modes, worked out from the mode
+        // number at compile time, so there's no lookup table in SRAM.
+        // The mode number is the value of WGM02:0, so bits 1:0 go in
+        // TCCR0A and bit 2 goes in TCCR0B.
+        //------------------------------------------------------------------
+        constexpr uint8_t modeBitsA(const uint8_t timerMode) {
+            return ((timerMode & 1) ? (1 << WGM00) : 0) |
+                   ((timerMode & 2) ? (1 << WGM01) : 0);
+        }
+
+        constexpr uint8_t modeBitsB(const uint8_t timerMode) {
+            return (timerMode & 4) ? (1 << WGM02) : 0;
+        }
 
         //------------------------------------------------------------------
         // CLOCK SOURCES. Note that external source, pin 'T0' is  physical
@@ -108,6 +107,59 @@ namespace AVRAssist {
         };
 
 
+        //------------------------------------------------------------------
+        // COMPILE TIME SOLVERS, see timersolver.h. Given F_CPU and a target
+        // frequency, in Hz, or period, in microseconds, these choose the
+        // timer mode, clock source and TOP value and report the error, all
+        // at compile time. The tolerance is in parts per million and
+        // defaults to 0.1%.
+        //
+        // Usage:
+        //
+        // typedef Timer0::Frequency<F_CPU, 1000> Tick;
+        // Timer0::initialise(Tick::mode, Tick::clockSource, ...);
+        // OCR0A = Tick::top;
+        //------------------------------------------------------------------
+
+        //------------------------------------------------------------------
+        // Division factor for a clock source. Zero for anything that
+        // isn't an internal prescaler.
+        //------------------------------------------------------------------
+        constexpr uint16_t prescaleDivisor(const uint8_t clockSource) {
+            return clockSource == CLK_PRESCALE_1    ? 1 :
+                   clockSource == CLK_PRESCALE_8    ? 8 :
+                   clockSource == CLK_PRESCALE_64   ? 64 :
+                   clockSource == CLK_PRESCALE_256  ? 256 :
+                   clockSource == CLK_PRESCALE_1024 ? 1024 : 0;
+        }
+
+        //------------------------------------------------------------------
+        // What the solvers need to know about Timer 0.
+        //------------------------------------------------------------------
+        struct SolverTimer {
+            typedef clockSource_t source_t;
+            typedef uint8_t top_t;
+            static constexpr uint32_t maximumTop = 255;
+            static constexpr uint8_t lastSource = CLK_PRESCALE_1024;
+            static constexpr uint8_t ctcMode = MODE_CTC_OCR0A;
+            static constexpr uint8_t fastPwm255Mode = MODE_FAST_PWM_255;
+            static constexpr uint8_t fastPwmTopMode = MODE_FAST_PWM_OCR0A;
+
+            static constexpr uint16_t divisor(const uint8_t clockSource) {
+                return prescaleDivisor(clockSource);
+            }
+        };
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct Frequency : TimerSolver::Ctc<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t microseconds, uint32_t tolerance = 1000>
+        struct Period : TimerSolver::Ctc<SolverTimer, uint64_t(cpuFrequency) * microseconds, 1000000, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct PwmFrequency : TimerSolver::FixedTopPwm<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+
         //------------------------------------------------------------------
         // Initialise Timer 0 with a requested timer mode and clock source.
         // Setting  the clock source to anything other than CLK_DISABLED 
@@ -118,7 +170,7 @@ namespace AVRAssist {
         // force compare (A and/or B) is to be carried out, defaults to
         // neither.
         //------------------------------------------------------------------
-        void initialise(const uint8_t timerMode, 
+        inline void initialise(const uint8_t timerMode, 
                         const clockSource_t clockSource, 
                         const compareMatch_t compareMatch = OCOX_DISCONNECTED, 
                         const interrupt_t enableInterrupts = INT_NONE) {
@@ -132,7 +184,7 @@ namespace AVRAssist {
 
             // Can't use OC0B_TOGGLE in anything but NORMAL and CTC modes.
             if ((timerMode != MODE_NORMAL && timerMode != MODE_CTC_OCR0A) && 
-                (compareMatch == OC0B_TOGGLE)) {
+                (compareMatch == OCOB_TOGGLE)) {
                 return;
             }
 
@@ -140,12 +192,12 @@ namespace AVRAssist {
             // Explicitly setting these will overwrite any previous settings
             // from the Arduino init() function, for example.
             //------------------------------------------------------------------
-            TCCR0A = (timerModes[timerMode][0]) | compareMatch;
-            TCCR0B = (timerModes[timerMode][1]) | clockSource;
+            TCCR0A = modeBitsA(timerMode) | compareMatch;
+            TCCR0B = modeBitsB(timerMode) | clockSource;
             TIMSK0 = enableInterrupts;
         }
 
-        void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
+        inline void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
             // Are we supposed to do anything?
             if (forcePin  == FORCE_COMPARE_NONE) {
                 return;
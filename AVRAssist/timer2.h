@@ -13,6 +13,8 @@
     #include <avr/io.h>
 #endif
 
+#include "timersolver.h"
+
 
 namespace AVRAssist {
     
@@ -23,7 +25,7 @@ namespace AVRAssist {
         
         //------------------------------------------------------------------
         // TIMER MODES. Modes 4 and 6 are reserved and not used. The rest 
-        // are simply used to index into the timerModes[][] array below.
+        // are the values of the WGM bits, see modeBitsA() and modeBitsB().
         //------------------------------------------------------------------
         enum  : uint8_t {
             MODE_NORMAL = 0,                        // Mode 0: Normal mode.
@@ -37,22 +39,19 @@ namespace AVRAssist {
         };
         
         //------------------------------------------------------------------
-        // TCCR2A and TCCR2B initial settings for the various timer modes. 
-        // TCCR2A is index [n][0]
-        // TCCR2B is index [n][1]
-        // These bits end up in WGM21 & WGM20 in TCCR2A and WGM22 in TCCR2B
-        // depending on the timer mode chosen from the above.
-        //------------------------------------------------------------------
-        const uint8_t timerModes[8][2] = {          // [n][0] = TCCR2A, [n][1] = TCCR2B
-            {0, 0},                                 // Normal, TOP = 255
-            {(1 << WGM20), 0},                      // Phase Correct PWM, TOP = 255
-            {(1 << WGM21), 0},                      // Clear Timer on Compare, TOP = OCR2A
-            {((1 << WGM20) | (1 << WGM21)), 0},     // Fast PWM, TOP = 255
-            {0, (1 << WGM22)},                      // Reserved - don't use
-            {((1 << WGM20), (1 << WGM22))},         // Phase Correct PWM, TOP = OCR2A
-            {((1 << WGM21), (1 << WGM22))},         // Reserved - don't use
-            {((1 << WGM20) | (1 << WGM21), (1 << WGM22))}     // Fast PWM, TOP = OCR2A
-        };
+        // WGM bits for the various timer modes, worked out from the mode
+        // number at compile time, so there's no lookup table in SRAM.
+        // The mode number is the value of WGM22:0, so bits 1:0 go in
+        // TCCR2A and bit 2 goes in TCCR2B.
+        //------------------------------------------------------------------
+        constexpr uint8_t modeBitsA(const uint8_t timerMode) {
+            return ((timerMode & 1) ? (1 << WGM20) : 0) |
+                   ((timerMode & 2) ? (1 << WGM21) : 0);
+        }
+
+        constexpr uint8_t modeBitsB(const uint8_t timerMode) {
+            return (timerMode & 4) ? (1 << WGM22) : 0;
+        }
 
         //------------------------------------------------------------------
         // CLOCK SOURCES. 
@@ -72,8 +71,8 @@ namespace AVRAssist {
         //------------------------------------------------------------------
         // COMPARE MATCH bits.
         // What happens when OCR2A, OCR2B match TCNT2? 
-        // Pin OC2A = Physical pin 12, Arduino pin D6 or AVR pin PD6.
-        // Pin OC2B = Physical pin 11, Arduino pin D5 or AVR pin PD5.
+        // Pin OC2A = Physical pin 17, Arduino pin D11 or AVR pin PB3.
+        // Pin OC2B = Physical pin 5, Arduino pin D3 or AVR pin PD3.
         //------------------------------------------------------------------
         enum compareMatch_t  : uint8_t {
             OC2X_DISCONNECTED = 0,                  // Nothing - OC2A, OC2B both disconnected.
@@ -104,7 +103,85 @@ namespace AVRAssist {
             FORCE_COMPARE_MATCH_A = (1 << FOC2A),
             FORCE_COMPARE_MATCH_B = (1 << FOC2B)
         };
+
+        //------------------------------------------------------------------
+        // ASYNCHRONOUS CLOCK bits. These end up in AS2 and EXCLK in the
+        // ASSR register. The crystal, usually 32.768 KHz, goes on pins
+        // TOSC1 and TOSC2, physical pins 9 and 10, AVR pins PB6 and PB7,
+        // which means no external crystal for the CPU. An external clock
+        // goes on TOSC1 only.
+        //------------------------------------------------------------------
+        enum asyncClock_t : uint8_t {
+            ASYNC_OFF = 0,                          // Clocked from the CPU clock.
+            ASYNC_CRYSTAL = (1 << AS2),             // Crystal on TOSC1 & TOSC2.
+            ASYNC_EXTERNAL = (1 << AS2) | (1 << EXCLK)  // External clock on TOSC1.
+        };
+
+        //------------------------------------------------------------------
+        // The ASSR update busy flags. When Timer 2 runs asynchronously,
+        // writes to TCNT2, OCR2A, OCR2B, TCCR2A and TCCR2B go into a
+        // temporary register, and take a couple of the slow clock's
+        // cycles to get through. Its flag is set until then, and writing
+        // again while it is set corrupts the value.
+        //------------------------------------------------------------------
+        const uint8_t ASYNC_BUSY = (1 << TCN2UB) | (1 << OCR2AUB) | (1 << OCR2BUB) |
+                                   (1 << TCR2AUB) | (1 << TCR2BUB);
         
+        //------------------------------------------------------------------
+        // COMPILE TIME SOLVERS, see timersolver.h. Given F_CPU and a target
+        // frequency, in Hz, or period, in microseconds, these choose the
+        // timer mode, clock source and TOP value and report the error, all
+        // at compile time. The tolerance is in parts per million and
+        // defaults to 0.1%.
+        //
+        // Usage:
+        //
+        // typedef Timer2::Frequency<F_CPU, 1000> Tick;
+        // Timer2::initialise(Tick::mode, Tick::clockSource, ...);
+        // OCR2A = Tick::top;
+        //------------------------------------------------------------------
+
+        //------------------------------------------------------------------
+        // Division factor for a clock source. Zero for anything that
+        // isn't an internal prescaler.
+        //------------------------------------------------------------------
+        constexpr uint16_t prescaleDivisor(const uint8_t clockSource) {
+            return clockSource == CLK_PRESCALE_1    ? 1 :
+                   clockSource == CLK_PRESCALE_8    ? 8 :
+                   clockSource == CLK_PRESCALE_32   ? 32 :
+                   clockSource == CLK_PRESCALE_64   ? 64 :
+                   clockSource == CLK_PRESCALE_128  ? 128 :
+                   clockSource == CLK_PRESCALE_256  ? 256 :
+                   clockSource == CLK_PRESCALE_1024 ? 1024 : 0;
+        }
+
+        //------------------------------------------------------------------
+        // What the solvers need to know about Timer 2.
+        //------------------------------------------------------------------
+        struct SolverTimer {
+            typedef clockSource_t source_t;
+            typedef uint8_t top_t;
+            static constexpr uint32_t maximumTop = 255;
+            static constexpr uint8_t lastSource = CLK_PRESCALE_1024;
+            static constexpr uint8_t ctcMode = MODE_CTC_OCR2A;
+            static constexpr uint8_t fastPwm255Mode = MODE_FAST_PWM_255;
+            static constexpr uint8_t fastPwmTopMode = MODE_FAST_PWM_OCR2A;
+
+            static constexpr uint16_t divisor(const uint8_t clockSource) {
+                return prescaleDivisor(clockSource);
+            }
+        };
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct Frequency : TimerSolver::Ctc<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t microseconds, uint32_t tolerance = 1000>
+        struct Period : TimerSolver::Ctc<SolverTimer, uint64_t(cpuFrequency) * microseconds, 1000000, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct PwmFrequency : TimerSolver::FixedTopPwm<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+
         //------------------------------------------------------------------
         // Initialise Timer 2 with a requested timer mode and clock source.
         // Setting  the clock source to anything other than CLK_DISABLED 
@@ -115,7 +192,7 @@ namespace AVRAssist {
         // force compare (A and/or B) is to be carried out, defaults to
         // neither.
         //------------------------------------------------------------------
-        void initialise(const uint8_t timerMode, 
+        inline void initialise(const uint8_t timerMode, 
                         const clockSource_t clockSource, 
                         const compareMatch_t compareMatch = OC2X_DISCONNECTED, 
                         const interrupt_t enableInterrupts = INT_NONE,
@@ -128,7 +205,7 @@ namespace AVRAssist {
 
             // Can't use OC0B_TOGGLE or FORCE COMPARE  in anything but NORMAL and CTC modes.
             if ((timerMode != MODE_NORMAL && timerMode != MODE_CTC_OCR2A) && 
-                (compareMatch == OC2B_TOGGLE || (forceCompare & FORCE_COMPARE_MATCH_A) || (forceCompare & FORCE_COMPARE_MATCH_B)) {
+                (compareMatch == OC2B_TOGGLE || (forceCompare & FORCE_COMPARE_MATCH_A) || (forceCompare & FORCE_COMPARE_MATCH_B))) {
                 return;
             }
 
@@ -136,12 +213,12 @@ namespace AVRAssist {
             // Explicitly setting these will overwrite any previous settings
             // from the Arduino init() function, for example.
             //------------------------------------------------------------------
-            TCCR2A = (timerModes[timerMode][0]) | compareMatch;
-            TCCR2B = (timerModes[timerMode][1]) | clockSource;
+            TCCR2A = modeBitsA(timerMode) | compareMatch;
+            TCCR2B = modeBitsB(timerMode) | clockSource;
             TIMSK2 = enableInterrupts;
         }
       
-        void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
+        inline void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
             // Are we supposed to do anything?
             if (forcePin  == FORCE_COMPARE_NONE) {
                 return;
@@ -152,6 +229,64 @@ namespace AVRAssist {
             TCCR2B |= forcePin;
         }
 
+        //------------------------------------------------------------------
+        // Wait until all writes to the asynchronous Timer 2 have got
+        // through. Returns straight away if not asynchronous.
+        //------------------------------------------------------------------
+        inline void waitForUpdate() {
+            while (ASSR & ASYNC_BUSY) {
+                ;
+            }
+        }
+
+        //------------------------------------------------------------------
+        // Initialise Timer 2 from the asynchronous clock, following the
+        // data sheet's sequence for changing over:
+        // 1. Disable the Timer 2 interrupts;
+        // 2. Select the asynchronous clock;
+        // 3. Write TCNT2, TCCR2A and TCCR2B;
+        // 4. Wait for the update busy flags to clear;
+        // 5. Clear the interrupt flags, which may have been set by glitches;
+        // 6. Enable the interrupts required.
+        // Set OCR2A or OCR2B, if needed, after this, and call waitForUpdate()
+        // after each write. Give a crystal about a second to settle down
+        // before relying on it.
+        //------------------------------------------------------------------
+        inline void initialiseAsync(const asyncClock_t asyncClock,
+                                    const uint8_t timerMode,
+                                    const clockSource_t clockSource,
+                                    const compareMatch_t compareMatch = OC2X_DISCONNECTED,
+                                    const interrupt_t enableInterrupts = INT_NONE) {
+            TIMSK2 = INT_NONE;
+
+            // EXCLK has to be set before AS2.
+            ASSR = asyncClock & (1 << EXCLK);
+            ASSR = asyncClock;
+
+            TCNT2 = 0;
+            initialise(timerMode, clockSource, compareMatch, INT_NONE);
+            waitForUpdate();
+
+            TIFR2 = (1 << OCF2B) | (1 << OCF2A) | (1 << TOV2);
+            TIMSK2 = enableInterrupts;
+        }
+
+        //------------------------------------------------------------------
+        // When Timer 2 has just woken the CPU from power save, at least
+        // one cycle of the slow clock has to pass before sleeping again,
+        // or the timer's interrupt logic may not have reset, and it won't
+        // wake the CPU next time. Rewriting TCCR2A and waiting for its
+        // update busy flag takes care of that. Call this just before
+        // sleeping. The same applies to reading TCNT2 just after waking.
+        //------------------------------------------------------------------
+        inline void waitForTimerClock() {
+            TCCR2A = TCCR2A;
+
+            while (ASSR & (1 << TCR2AUB)) {
+                ;
+            }
+        }
+
     }  // End of Timer2 namespace.
   
 }  // End of AVRAssist namespace.
@@ -0,0 +1,345 @@
+#ifndef __TIMERWHEEL_H__
+#define __TIMERWHEEL_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+#include <avr/interrupt.h>
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // Callback for an expired software timer. It is passed the id of the
+    // timer, from allocate(), and is called from dispatch(), in the main
+    // loop, never from the interrupt handler.
+    //----------------------------------------------------------------------
+    typedef void (*wheelCallback_t)(const uint8_t id);
+
+    const uint8_t WHEEL_NONE = 0xFF;
+
+    //----------------------------------------------------------------------
+    // Lots of software timers on one hardware timer interrupt.
+    //
+    // Timers come from a fixed pool, and live on one of two wheels of 64
+    // slots each. The first wheel has a slot per tick, for timers due in
+    // the next 64 ticks. The second wheel has a slot per 64 ticks, for
+    // timers due in the next 4,096 ticks, or later. Every 64 ticks, one
+    // slot of the second wheel is emptied back onto the first, which is
+    // called cascading.
+    //
+    // Each slot is a doubly linked list, linked by 8 bit pool indices,
+    // so starting or cancelling a timer is always the same few pointer
+    // changes, however many timers are running. tick() only ever looks
+    // at the one slot that is due, plus, once every 64 ticks, the one
+    // slot being cascaded.
+    //
+    // Usage:
+    //
+    // TimerWheel<16> timers;
+    //
+    // ISR(TIMER2_COMPA_vect) {
+    //     timers.tick();
+    // }
+    //
+    // uint8_t timeout = timers.allocate(onTimeout);
+    // timers.start(timeout, 250);
+    // ...
+    // while (1) {
+    //     timers.dispatch();
+    // }
+    //
+    // Everything other than tick() is for the main loop, and briefly
+    // disables interrupts while it alters the lists.
+    //----------------------------------------------------------------------
+    template <uint8_t poolSize>
+    class TimerWheel {
+        static_assert(poolSize >= 1 && poolSize <= 250,
+                      "TimerWheel pool size must be 1 to 250.");
+
+    public:
+        TimerWheel() : ticks(0), expired(WHEEL_NONE), freeList(0) {
+            for (uint8_t slot = 0; slot < SLOTS * 2; slot++) {
+                wheel[slot] = WHEEL_NONE;
+            }
+
+            for (uint8_t id = 0; id < poolSize; id++) {
+                pool[id].next = (id + 1 < poolSize) ? id + 1 : WHEEL_NONE;
+                pool[id].where = WHERE_FREE;
+            }
+        }
+
+        //------------------------------------------------------------------
+        // Take a timer from the pool. Returns WHEEL_NONE if they are all
+        // in use. The timer is not running until start() is called.
+        //------------------------------------------------------------------
+        uint8_t allocate(const wheelCallback_t callback) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            uint8_t id = freeList;
+
+            if (id != WHEEL_NONE) {
+                freeList = pool[id].next;
+                pool[id].where = WHERE_IDLE;
+                pool[id].callback = callback;
+            }
+
+            restore(oldSREG);
+            return id;
+        }
+
+        //------------------------------------------------------------------
+        // Cancel a timer, if running, and give it back to the pool.
+        //------------------------------------------------------------------
+        void release(const uint8_t id) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            if (pool[id].where != WHERE_FREE) {
+                unlink(id);
+                pool[id].where = WHERE_FREE;
+                pool[id].next = freeList;
+                freeList = id;
+            }
+
+            restore(oldSREG);
+        }
+
+        //------------------------------------------------------------------
+        // (Re)start a timer, to expire 'delay' ticks from now. A delay of
+        // zero is treated as one. It may be called from the timer's own
+        // callback for a repeating timer.
+        //------------------------------------------------------------------
+        void start(const uint8_t id, const uint32_t delay) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            if (pool[id].where != WHERE_FREE) {
+                unlink(id);
+                pool[id].expires = ticks + (delay ? delay : 1);
+                insert(id);
+            }
+
+            restore(oldSREG);
+        }
+
+        //------------------------------------------------------------------
+        // Stop a timer. If it has already expired, but dispatch() hasn't
+        // got round to it yet, the callback will not be called.
+        //------------------------------------------------------------------
+        void cancel(const uint8_t id) {
+            uint8_t oldSREG = SREG;
+            cli();
+
+            if (pool[id].where != WHERE_FREE) {
+                unlink(id);
+            }
+
+            restore(oldSREG);
+        }
+
+        //------------------------------------------------------------------
+        // Is the timer counting down, or expired and waiting for
+        // dispatch()? A single byte read, so no need to disable interrupts.
+        //------------------------------------------------------------------
+        bool running(const uint8_t id) const {
+            uint8_t where = *static_cast<const volatile uint8_t *>(&pool[id].where);
+            return where < WHERE_IDLE;
+        }
+
+        //------------------------------------------------------------------
+        // Ticks since the wheel was created.
+        //------------------------------------------------------------------
+        uint32_t now() const {
+            uint8_t oldSREG = SREG;
+            cli();
+            uint32_t result = ticks;
+            restore(oldSREG);
+            return result;
+        }
+
+        //------------------------------------------------------------------
+        // Call this from the hardware timer's interrupt handler, once per
+        // tick. Expired timers are moved to a list for dispatch().
+        //------------------------------------------------------------------
+        void tick() {
+            uint32_t current = ++ticks;
+            uint8_t slot = current & SLOT_MASK;
+
+            // Cascade first, anything due on this very tick ends up in
+            // 'slot' below.
+            if (slot == 0) {
+                uint8_t id = detach(SLOTS + ((current >> SLOT_BITS) & SLOT_MASK));
+
+                while (id != WHEEL_NONE) {
+                    uint8_t next = pool[id].next;
+                    insert(id);
+                    id = next;
+                }
+            }
+
+            uint8_t id = detach(slot);
+
+            while (id != WHEEL_NONE) {
+                uint8_t next = pool[id].next;
+                push(WHERE_EXPIRED, id);
+                id = next;
+            }
+        }
+
+        //------------------------------------------------------------------
+        // Call this from the main loop. Runs the callback for every timer
+        // that has expired. Returns the number of callbacks run.
+        //------------------------------------------------------------------
+        uint8_t dispatch() {
+            uint8_t count = 0;
+
+            while (1) {
+                uint8_t oldSREG = SREG;
+                cli();
+
+                uint8_t id = expired;
+                wheelCallback_t callback = 0;
+
+                if (id != WHEEL_NONE) {
+                    unlink(id);
+                    callback = pool[id].callback;
+                }
+
+                restore(oldSREG);
+
+                if (id == WHEEL_NONE) {
+                    return count;
+                }
+
+                if (callback) {
+                    callback(id);
+                }
+
+                count++;
+            }
+        }
+
+    private:
+        static const uint8_t SLOT_BITS = 6;
+        static const uint8_t SLOTS = 1 << SLOT_BITS;
+        static const uint8_t SLOT_MASK = SLOTS - 1;
+
+        //------------------------------------------------------------------
+        // Where each timer is. 0 to 63 are slots on the first wheel, 64
+        // to 127 slots on the second.
+        //------------------------------------------------------------------
+        static const uint8_t WHERE_EXPIRED = SLOTS * 2;
+        static const uint8_t WHERE_IDLE = 0xFE;
+        static const uint8_t WHERE_FREE = 0xFF;
+
+        struct node_t {
+            uint32_t expires;           // Tick count it is due on.
+            wheelCallback_t callback;
+            uint8_t next;               // Pool index, or WHEEL_NONE.
+            uint8_t previous;           // Pool index, or WHEEL_NONE.
+            uint8_t where;              // Slot, or one of WHERE_xxx.
+        };
+
+        //------------------------------------------------------------------
+        // Turn interrupts back on, if they were on. The barrier stops the
+        // compiler moving list changes after the point where the interrupt
+        // handler can see them.
+        //------------------------------------------------------------------
+        static void restore(const uint8_t oldSREG) {
+            __asm__ __volatile__ ("" ::: "memory");
+            SREG = oldSREG;
+        }
+
+        //------------------------------------------------------------------
+        // The list head for a 'where'.
+        //------------------------------------------------------------------
+        uint8_t &head(const uint8_t where) {
+            return where == WHERE_EXPIRED ? expired : wheel[where];
+        }
+
+        //------------------------------------------------------------------
+        // Add a timer to the front of a list.
+        //------------------------------------------------------------------
+        void push(const uint8_t where, const uint8_t id) {
+            uint8_t &first = head(where);
+
+            pool[id].where = where;
+            pool[id].previous = WHEEL_NONE;
+            pool[id].next = first;
+
+            if (first != WHEEL_NONE) {
+                pool[first].previous = id;
+            }
+
+            first = id;
+        }
+
+        //------------------------------------------------------------------
+        // Take a timer off whatever list it is on, if any.
+        //------------------------------------------------------------------
+        void unlink(const uint8_t id) {
+            node_t &node = pool[id];
+
+            if (node.where >= WHERE_IDLE) {
+                return;
+            }
+
+            if (node.previous != WHEEL_NONE) {
+                pool[node.previous].next = node.next;
+            } else {
+                head(node.where) = node.next;
+            }
+
+            if (node.next != WHEEL_NONE) {
+                pool[node.next].previous = node.previous;
+            }
+
+            node.where = WHERE_IDLE;
+        }
+
+        //------------------------------------------------------------------
+        // Empty a slot, returning its old list.
+        //------------------------------------------------------------------
+        uint8_t detach(const uint8_t slot) {
+            uint8_t first = wheel[slot];
+            wheel[slot] = WHEEL_NONE;
+            return first;
+        }
+
+        //------------------------------------------------------------------
+        // Put a timer on the right wheel for its expiry time. Anything
+        // 4,096 or more ticks away goes on the second wheel anyway, and
+        // gets put back again each time that slot is cascaded, until it
+        // is close enough.
+        //------------------------------------------------------------------
+        void insert(const uint8_t id) {
+            uint32_t expires = pool[id].expires;
+
+            if (expires - ticks < SLOTS) {
+                push(expires & SLOT_MASK, id);
+            } else {
+                push(SLOTS + ((expires >> SLOT_BITS) & SLOT_MASK), id);
+            }
+        }
+
+        node_t pool[poolSize];
+        uint8_t wheel[SLOTS * 2];       // List heads, both wheels.
+        uint32_t ticks;
+        uint8_t expired;                // List head, waiting for dispatch().
+        uint8_t freeList;               // Singly linked, through 'next'.
+    };
+
+}  // End of AVRAssist namespace.
+
+#endif // __TIMERWHEEL_H__
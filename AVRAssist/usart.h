@@ -0,0 +1,84 @@
+#ifndef __USART_H__
+#define __USART_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // USART 0 setup. Asynchronous, 8 data bits, no parity, 1 stop bit.
+    //----------------------------------------------------------------------
+    namespace Usart {
+
+        //------------------------------------------------------------------
+        // INTERRUPTS to enable. These bits end up in the UCSR0B register.
+        //------------------------------------------------------------------
+        enum interrupt_t : uint8_t {
+            INT_NONE = 0,
+            INT_RX_COMPLETE = (1 << RXCIE0),
+            INT_TX_COMPLETE = (1 << TXCIE0),
+            INT_DATA_EMPTY = (1 << UDRIE0)
+        };
+
+        //------------------------------------------------------------------
+        // The UBRR0 value for a baud rate, in double speed (U2X0) mode,
+        // rounded to the nearest.
+        //------------------------------------------------------------------
+        constexpr uint16_t baudRegister(const uint32_t cpuFrequency,
+                                        const uint32_t baudRate) {
+            return (cpuFrequency + baudRate * 4) / (baudRate * 8) - 1;
+        }
+
+        //------------------------------------------------------------------
+        // Initialise USART 0 for the requested baud rate, in double speed
+        // mode, with the transmitter and receiver both enabled. This will
+        // overwrite anything that Serial.begin() set up.
+        //------------------------------------------------------------------
+        inline void initialise(const uint32_t baudRate,
+                               const interrupt_t enableInterrupts = INT_NONE) {
+            PRR &= ~(1 << PRUSART0);    // Power enabled to the USART.
+            UCSR0B = 0;
+            UCSR0A = (1 << U2X0);
+            UBRR0 = baudRegister(F_CPU, baudRate);
+            UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+            UCSR0B = (1 << RXEN0) | (1 << TXEN0) | enableInterrupts;
+        }
+
+        //------------------------------------------------------------------
+        // Turn the data register empty interrupt on and off. An interrupt
+        // driven transmitter turns it on when it has something to send,
+        // and off again, in ISR(USART_UDRE_vect), when it has finished.
+        //------------------------------------------------------------------
+        inline void enableDataEmptyInterrupt() {
+            UCSR0B |= (1 << UDRIE0);
+        }
+
+        inline void disableDataEmptyInterrupt() {
+            UCSR0B &= ~(1 << UDRIE0);
+        }
+
+        //------------------------------------------------------------------
+        // Polled transmit of a single byte.
+        //------------------------------------------------------------------
+        inline void write(const uint8_t value) {
+            while (!(UCSR0A & (1 << UDRE0))) {
+                ;
+            }
+
+            UDR0 = value;
+        }
+
+    } // End of Usart namespace.
+
+}  // End of AVRAssist namespace.
+#endif // __USART_H__
@@ -0,0 +1,258 @@
+#ifndef __TIMERSOLVER_H__
+#define __TIMERSOLVER_H__
+
+// The following should allow the Arduino IDE or not, to
+// use this header file.
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include "Arduino.h"
+    #else
+        #include "WProgram.h"
+    #endif
+#else
+    #include <avr/io.h>
+#endif
+
+
+namespace AVRAssist {
+
+    //----------------------------------------------------------------------
+    // COMPILE TIME SOLVERS, shared by all three timers. Given F_CPU and a
+    // target frequency, or period, these choose the timer mode, clock
+    // source and TOP value and report the error, all at compile time.
+    // They refuse to compile if the error would be outside the
+    // tolerance, which is in parts per million.
+    //
+    // Each timer header describes its own timer with a small traits
+    // struct, SolverTimer, and provides the Frequency, Period and
+    // PwmFrequency templates on top of these. The traits are:
+    //
+    // source_t         - the timer's clockSource_t.
+    // top_t            - uint8_t or uint16_t, the width of TOP.
+    // maximumTop       - 255 or 65535.
+    // lastSource       - CLK_PRESCALE_1024, the last internal prescaler.
+    // divisor()        - the timer's prescaleDivisor().
+    // ctcMode          - CTC mode with TOP in OCRnA.
+    //
+    // plus the PWM modes each PWM solver below needs.
+    //
+    // The target is 'cycles' / 'scale' CPU clock cycles per period. The
+    // counter counts TOP + 1 timer clocks per period. CLK_DISABLED, zero,
+    // means that nothing fits.
+    //----------------------------------------------------------------------
+    namespace TimerSolver {
+
+        constexpr uint64_t difference(const uint64_t actual,
+                                      const uint64_t target) {
+            return actual > target ? actual - target : target - actual;
+        }
+
+        //------------------------------------------------------------------
+        // Number of bits needed to hold TOP, ie the PWM resolution.
+        //------------------------------------------------------------------
+        constexpr uint8_t bits(const uint32_t top) {
+            return top ? 1 + bits(top >> 1) : 0;
+        }
+
+        template <typename Timer>
+        struct Sums {
+            static constexpr uint64_t counts(const uint64_t cycles,
+                                             const uint64_t scale,
+                                             const uint8_t clockSource) {
+                return (cycles + (scale * Timer::divisor(clockSource)) / 2) /
+                       (scale * Timer::divisor(clockSource));
+            }
+
+            static constexpr bool fits(const uint64_t cycles,
+                                       const uint64_t scale,
+                                       const uint8_t clockSource) {
+                return counts(cycles, scale, clockSource) >= 2 &&
+                       counts(cycles, scale, clockSource) - 1 <= Timer::maximumTop;
+            }
+
+            static constexpr uint32_t error(const uint64_t cycles,
+                                            const uint64_t scale,
+                                            const uint8_t clockSource) {
+                return difference(counts(cycles, scale, clockSource) *
+                                  Timer::divisor(clockSource) * scale,
+                                  cycles) * 1000000ULL / cycles;
+            }
+
+            //--------------------------------------------------------------
+            // The clock source giving the smallest error, the smaller
+            // prescaler wins a tie.
+            //--------------------------------------------------------------
+            static constexpr uint8_t closest(const uint64_t cycles,
+                                             const uint64_t scale,
+                                             const uint8_t clockSource = 1,
+                                             const uint8_t best = 0) {
+                return clockSource > Timer::lastSource ? best :
+                       closest(cycles, scale, clockSource + 1,
+                               fits(cycles, scale, clockSource) &&
+                               (best == 0 ||
+                                error(cycles, scale, clockSource) < error(cycles, scale, best))
+                               ? clockSource : best);
+            }
+
+            //--------------------------------------------------------------
+            // The smallest prescaler, so the largest TOP and the best PWM
+            // resolution, within the tolerance.
+            //--------------------------------------------------------------
+            static constexpr uint8_t finest(const uint64_t cycles,
+                                            const uint64_t scale,
+                                            const uint32_t tolerance,
+                                            const uint8_t clockSource = 1) {
+                return clockSource > Timer::lastSource ? 0 :
+                       (fits(cycles, scale, clockSource) &&
+                        error(cycles, scale, clockSource) <= tolerance)
+                       ? clockSource
+                       : finest(cycles, scale, tolerance, clockSource + 1);
+            }
+
+            //--------------------------------------------------------------
+            // Error, in ppm, with TOP fixed at maximumTop, and the first
+            // prescaler within tolerance that way.
+            //--------------------------------------------------------------
+            static constexpr uint32_t fixedTopError(const uint64_t cycles,
+                                                    const uint64_t scale,
+                                                    const uint8_t clockSource) {
+                return difference((uint64_t(Timer::maximumTop) + 1) * Timer::divisor(clockSource) * scale,
+                                  cycles) * 1000000ULL / cycles;
+            }
+
+            static constexpr uint8_t fixedTopSource(const uint64_t cycles,
+                                                    const uint64_t scale,
+                                                    const uint32_t tolerance,
+                                                    const uint8_t clockSource = 1) {
+                return clockSource > Timer::lastSource ? 0 :
+                       fixedTopError(cycles, scale, clockSource) <= tolerance
+                       ? clockSource
+                       : fixedTopSource(cycles, scale, tolerance, clockSource + 1);
+            }
+        };
+
+        //------------------------------------------------------------------
+        // CTC solver. TOP goes in OCRnA, and the compare match A interrupt
+        // fires once per period.
+        //------------------------------------------------------------------
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        struct Ctc {
+            typedef typename Timer::source_t source_t;
+            typedef typename Timer::top_t top_t;
+            typedef Sums<Timer> sums;
+
+            static constexpr uint8_t mode = Timer::ctcMode;
+            static constexpr source_t clockSource = source_t(sums::closest(cycles, scale));
+            static constexpr top_t top = clockSource == 0 ? 0 : sums::counts(cycles, scale, clockSource) - 1;
+            static constexpr uint32_t errorPpm = clockSource == 0 ? 0 : sums::error(cycles, scale, clockSource);
+
+            static_assert(clockSource != 0,
+                          "The timer cannot generate this frequency or period.");
+            static_assert(errorPpm <= tolerance,
+                          "The timer cannot get within tolerance of this frequency or period.");
+        };
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint8_t Ctc<Timer, cycles, scale, tolerance>::mode;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::source_t Ctc<Timer, cycles, scale, tolerance>::clockSource;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::top_t Ctc<Timer, cycles, scale, tolerance>::top;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint32_t Ctc<Timer, cycles, scale, tolerance>::errorPpm;
+
+        //------------------------------------------------------------------
+        // PWM solver for the 8 bit timers. If a prescaler gets within
+        // tolerance with TOP fixed at 255, Timer::fastPwm255Mode is used,
+        // giving the full 8 bits of resolution on both OCnA and OCnB.
+        // Otherwise, it's Timer::fastPwmTopMode with TOP in OCRnA, the
+        // smallest prescaler within tolerance for the best resolution,
+        // and only OCnB is available for PWM output.
+        //------------------------------------------------------------------
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        struct FixedTopPwm {
+            typedef typename Timer::source_t source_t;
+            typedef typename Timer::top_t top_t;
+            typedef Sums<Timer> sums;
+
+            static constexpr bool fixedTop = sums::fixedTopSource(cycles, scale, tolerance) != 0;
+            static constexpr uint8_t mode = fixedTop ? Timer::fastPwm255Mode : Timer::fastPwmTopMode;
+            static constexpr source_t clockSource = source_t(fixedTop
+                                                    ? sums::fixedTopSource(cycles, scale, tolerance)
+                                                    : sums::finest(cycles, scale, tolerance));
+            static constexpr top_t top = clockSource == 0 ? 0 :
+                                         fixedTop ? Timer::maximumTop : sums::counts(cycles, scale, clockSource) - 1;
+            static constexpr uint32_t errorPpm = clockSource == 0 ? 0 :
+                                                 fixedTop ? sums::fixedTopError(cycles, scale, clockSource)
+                                                          : sums::error(cycles, scale, clockSource);
+            static constexpr uint8_t resolutionBits = bits(top);
+
+            static_assert(clockSource != 0,
+                          "The timer cannot get within tolerance of this PWM frequency.");
+        };
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr bool FixedTopPwm<Timer, cycles, scale, tolerance>::fixedTop;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint8_t FixedTopPwm<Timer, cycles, scale, tolerance>::mode;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::source_t FixedTopPwm<Timer, cycles, scale, tolerance>::clockSource;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::top_t FixedTopPwm<Timer, cycles, scale, tolerance>::top;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint32_t FixedTopPwm<Timer, cycles, scale, tolerance>::errorPpm;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint8_t FixedTopPwm<Timer, cycles, scale, tolerance>::resolutionBits;
+
+        //------------------------------------------------------------------
+        // PWM solver for Timer 1. Timer::pwmMode, fast PWM with TOP in
+        // ICR1, which leaves OCR1A and OCR1B free for the duty cycles. The
+        // smallest prescaler within tolerance is chosen, as that gives the
+        // largest TOP and so the highest duty cycle resolution.
+        //------------------------------------------------------------------
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        struct VariableTopPwm {
+            typedef typename Timer::source_t source_t;
+            typedef typename Timer::top_t top_t;
+            typedef Sums<Timer> sums;
+
+            static constexpr uint8_t mode = Timer::pwmMode;
+            static constexpr source_t clockSource = source_t(sums::finest(cycles, scale, tolerance));
+            static constexpr top_t top = clockSource == 0 ? 0 : sums::counts(cycles, scale, clockSource) - 1;
+            static constexpr uint32_t errorPpm = clockSource == 0 ? 0 : sums::error(cycles, scale, clockSource);
+            static constexpr uint8_t resolutionBits = bits(top);
+
+            static_assert(clockSource != 0,
+                          "The timer cannot get within tolerance of this PWM frequency.");
+            static_assert(top >= 3,
+                          "The PWM frequency is too high, TOP must be at least 3.");
+        };
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint8_t VariableTopPwm<Timer, cycles, scale, tolerance>::mode;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::source_t VariableTopPwm<Timer, cycles, scale, tolerance>::clockSource;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr typename Timer::top_t VariableTopPwm<Timer, cycles, scale, tolerance>::top;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint32_t VariableTopPwm<Timer, cycles, scale, tolerance>::errorPpm;
+
+        template <typename Timer, uint64_t cycles, uint64_t scale, uint32_t tolerance>
+        constexpr uint8_t VariableTopPwm<Timer, cycles, scale, tolerance>::resolutionBits;
+
+    }  // End of TimerSolver namespace.
+
+}  // End of AVRAssist namespace.
+
+#endif // __TIMERSOLVER_H__
@@ -1,6 +1,8 @@
 #include <avr/interrupt.h>
 #include "adc.h"
 #include "timer1.h"
+#include "ringbuffer.h"
+#include "pwm.h"
 
 using namespace AVRAssist;
 
@@ -41,13 +43,23 @@ long map(long x, long in_min, long in_max, long out_min, long out_max)
 }
 
 
-// Somewhere for the ADC Interrupt to store the result.
-volatile uint16_t ADCReading = 0;
+// Somewhere for the ADC Interrupt to store the results. At 16 MHz
+// with a divide by 128 prescaler, free running mode gives about 9,600
+// samples a second, so 64 slots gives over 6 mS of slack for the main
+// loop to be busy elsewhere before any samples are lost.
+RingBuffer<uint16_t, 64> ADCReadings;
 
 
-// The interrupt handler.
+// The interrupt handler. This never needs to disable interrupts.
 ISR(ADC_vect) {
-    ADCReading = ADCW;
+    ADCReadings.push(ADCW);
+}
+
+
+// Timer1 overflows at BOTTOM in phase correct mode, which is where any
+// new duty cycle is written to OCR1A.
+ISR(TIMER1_OVF_vect) {
+    Pwm<1>::handleInterrupt();
 }
 
 
@@ -60,6 +72,7 @@ int main() {
     // Initialise Timer1 in 8 bit PC PWM with divide by 64
     // clock prescaler.
     setupTimer1();
+    Pwm<1>::initialise();
 
     // Initialise the ADC in free running mode with a divide by 128
     // clock prescaler using ADC0 (A0, PC0) as the sample voltage.
@@ -71,9 +84,18 @@ int main() {
     // Now, fire up the ADC.
     Adc::start();
 
+    // Somewhere to drain the ring buffer into.
+    uint16_t block[16];
+
     while (1) { 
-        // Adjust the brightness of the LED on PIN D9.
-        // That gives 0 - 1023, we need 0 to 255.
-        OCR1A = map(ADCReading, 0, 1023, 0, 255);
+        // Grab everything that has arrived since last time, in blocks.
+        uint8_t count = ADCReadings.read(block, sizeof(block) / sizeof(block[0]));
+
+        if (count) {
+            // Adjust the brightness of the LED on PIN D9 using the most
+            // recent reading. That gives 0 - 1023, we need 0 to 255.
+            // It's applied at the end of the current PWM period.
+            Pwm<1>::set(PWM_A, map(block[count - 1], 0, 1023, 0, 255));
+        }
     }
 }
@@ -59,7 +59,7 @@ namespace AVRAssist {
         // Initialise the analogue comparator with a reference voltage
         // source, a comparison voltage source and any required interrupts.
         //------------------------------------------------------------------
-        void initialise(const reference_t referenceSource, 
+        inline void initialise(const reference_t referenceSource, 
                         const sample_t sampleSource, 
                         const interrupt_t interruptMode = INT_NONE) {
 
@@ -13,6 +13,10 @@
     #include <avr/io.h>
 #endif
 
+#include <avr/interrupt.h>
+
+#include "timersolver.h"
+
 namespace AVRAssist {
     
     //----------------------------------------------------------------------
@@ -22,7 +26,7 @@ namespace AVRAssist {
         
         //------------------------------------------------------------------
         // TIMER MODES. Mode 13 is reserved and not used.  The rest are
-        // simply used to index into the timerModes[][] array below.
+        // simply the values of the WGM bits, see modeBitsA() and modeBitsB().
         //------------------------------------------------------------------
         enum  : uint8_t {
             MODE_NORMAL = 0,                        // Mode 0: Normal mode.                        
@@ -44,31 +48,21 @@ namespace AVRAssist {
         };
         
         //------------------------------------------------------------------
-        // TCCR1A and TCCR1B initial settings for the various timer modes. 
-        // TCCR1A is index [n][0]
-        // TCCR1B is index [n][1]
-        // These bits end up in WGM11 & WGM10 in TCCR1A and WGM13 & WGM02 in 
-        // TCCR1B depending on the timer mode chosen from the above.
-        //------------------------------------------------------------------
-        const uint8_t timerModes[16][2] = {                 // [n][0] = TCCR1A, [n][1] = TCCR1B
-            {0, 0},                                         // Normal, TOP = 65,535
-            {(1 << WGM10), 0},                              // Phase Correct PWM - 8 bit, TOP = 255
-            {(1 << WGM11), 0},                              // Phase Correct PWM - 9 bit, TOP = 511
-            {((1 << WGM10) | (1 << WGM11)), 0},             // Phase Correct PWM - 10 bit, TOP = 1,023
-            {0, (1 << WGM12) },                             // Clear Timer on Compare, TOP = OCR1A
-            {(1 << WGM10), (1 << WGM12)},                   // Fast PWM 8 bit, TOP = 255
-            {(1 << WGM11), (1 << WGM12)},                   // Fast PWM 9 bit, TOP = 511
-            {((1 << WGM10) | (1 << WGM11)), (1 << WGM12)},  // Fast PWM 10 bit- TOP = 1,023
-            {0, (1 << WGM13)},                              // Phase & Frequency Correct PWM, TOP = ICR1    
-            {(1 << WGM10), (1 << WGM13)},                   // Phase & Frequency Correct PWM, TOP = OCR1A    
-            {(1 << WGM11), (1 << WGM13)},                   // Phase Correct PWM, TOP = ICR1A    
-            {((1 << WGM10) | (1 << WGM11)), (1 << WGM13)},  // Phase Correct PWM, TOP = OCR1A
-            {0, ((1 << WGM12) | (1 << WGM13))},             // Clear Timer on Compare, TOP = ICR1    
-            {(1 << WGM10), ((1 << WGM12) | (1 << WGM13))},  // Reserved, don't use.
-            {(1 << WGM11), ((1 << WGM12) | (1 << WGM13))},  // Fast PWM, TOP = ICR1
-            {((1 << WGM10) | (1 << WGM11)), ((1 << WGM12) | (1 << WGM13))}, // Fast PWM, TOP = OCR1A
-        };  // end of Timer1::Modes
-      
+        // WGM bits for the various timer modes, worked out from the mode
+        // number at compile time, so there's no lookup table in SRAM.
+        // The mode number is the value of WGM13:0, so bits 1:0 go in
+        // TCCR1A and bits 3:2 go in TCCR1B.
+        //------------------------------------------------------------------
+        constexpr uint8_t modeBitsA(const uint8_t timerMode) {
+            return ((timerMode & 1) ? (1 << WGM10) : 0) |
+                   ((timerMode & 2) ? (1 << WGM11) : 0);
+        }
+
+        constexpr uint8_t modeBitsB(const uint8_t timerMode) {
+            return ((timerMode & 4) ? (1 << WGM12) : 0) |
+                   ((timerMode & 8) ? (1 << WGM13) : 0);
+        }
+
         //------------------------------------------------------------------
         // CLOCK SOURCES. Note that external source, pin 'T1' is 
         // physical pin 11, Arduino pin D5 or AVR pin PD5.
@@ -132,6 +126,163 @@ namespace AVRAssist {
             INPCAP_NOISE_CANCEL_ON_RISING_EDGE = (1 << ICNC1) | (1 << ICES1)
         };
 
+        //------------------------------------------------------------------
+        // COMPILE TIME SOLVERS, see timersolver.h. Given F_CPU and a target
+        // frequency, in Hz, or period, in microseconds, these choose the
+        // timer mode, clock source and TOP value and report the error, all
+        // at compile time. The tolerance is in parts per million and
+        // defaults to 0.1%.
+        //
+        // Usage:
+        //
+        // typedef Timer1::Frequency<F_CPU, 1000> Tick;
+        // Timer1::initialise(Tick::mode, Tick::clockSource, ...);
+        // OCR1A = Tick::top;
+        //------------------------------------------------------------------
+
+        //------------------------------------------------------------------
+        // Division factor for a clock source. Zero for anything that
+        // isn't an internal prescaler.
+        //------------------------------------------------------------------
+        constexpr uint16_t prescaleDivisor(const uint8_t clockSource) {
+            return clockSource == CLK_PRESCALE_1    ? 1 :
+                   clockSource == CLK_PRESCALE_8    ? 8 :
+                   clockSource == CLK_PRESCALE_64   ? 64 :
+                   clockSource == CLK_PRESCALE_256  ? 256 :
+                   clockSource == CLK_PRESCALE_1024 ? 1024 : 0;
+        }
+
+        //------------------------------------------------------------------
+        // What the solvers need to know about Timer 1.
+        //------------------------------------------------------------------
+        struct SolverTimer {
+            typedef clockSource_t source_t;
+            typedef uint16_t top_t;
+            static constexpr uint32_t maximumTop = 65535;
+            static constexpr uint8_t lastSource = CLK_PRESCALE_1024;
+            static constexpr uint8_t ctcMode = MODE_CTC_OCR1A;
+            static constexpr uint8_t pwmMode = MODE_FAST_PWM_1CR1;
+
+            static constexpr uint16_t divisor(const uint8_t clockSource) {
+                return prescaleDivisor(clockSource);
+            }
+        };
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct Frequency : TimerSolver::Ctc<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t microseconds, uint32_t tolerance = 1000>
+        struct Period : TimerSolver::Ctc<SolverTimer, uint64_t(cpuFrequency) * microseconds, 1000000, tolerance> {};
+
+        template <uint32_t cpuFrequency, uint32_t frequency, uint32_t tolerance = 1000>
+        struct PwmFrequency : TimerSolver::VariableTopPwm<SolverTimer, cpuFrequency, frequency, tolerance> {};
+
+
+        //------------------------------------------------------------------
+        // 16 BIT REGISTERS. The CPU reads and writes TCNT1, OCR1A, OCR1B
+        // and ICR1 a byte at a time, through a single TEMP register shared
+        // by all of them. If an ISR uses any of them in between the two
+        // halves of an access from the main loop, TEMP is overwritten and
+        // the main loop gets, or writes, a corrupt value.
+        //
+        // These disable interrupts for the two byte accesses only, and
+        // put them back as they were. Reading OCR1A or OCR1B doesn't use
+        // TEMP, so those need no protection at all. Inside an ISR, where
+        // interrupts are already off, the registers can be used directly.
+        //------------------------------------------------------------------
+        inline void atomicWrite(volatile uint16_t &timerRegister, const uint16_t value) {
+            uint8_t oldSREG = SREG;
+            cli();
+            timerRegister = value;
+            SREG = oldSREG;
+        }
+
+        inline uint16_t atomicRead(volatile uint16_t &timerRegister) {
+            uint8_t oldSREG = SREG;
+            cli();
+            uint16_t value = timerRegister;
+            SREG = oldSREG;
+            return value;
+        }
+
+        inline uint16_t readTCNT1() { return atomicRead(TCNT1); }
+        inline uint16_t readICR1() { return atomicRead(ICR1); }
+        inline uint16_t readOCR1A() { return OCR1A; }
+        inline uint16_t readOCR1B() { return OCR1B; }
+
+        inline void writeTCNT1(const uint16_t value) { atomicWrite(TCNT1, value); }
+        inline void writeICR1(const uint16_t value) { atomicWrite(ICR1, value); }
+        inline void writeOCR1A(const uint16_t value) { atomicWrite(OCR1A, value); }
+        inline void writeOCR1B(const uint16_t value) { atomicWrite(OCR1B, value); }
+
+        //------------------------------------------------------------------
+        // QUEUED VALUES for OCR1A, OCR1B and ICR1, which are written at
+        // the end of the next initialise(), after the mode has been set.
+        // Values written to these registers before initialise() can be
+        // lost, see the Foibles, so queueing them means the order of the
+        // calls in your code no longer matters.
+        //------------------------------------------------------------------
+        enum queued_t : uint8_t {
+            QUEUED_NONE = 0,
+            QUEUED_OCR1A = (1 << 0),
+            QUEUED_OCR1B = (1 << 1),
+            QUEUED_ICR1 = (1 << 2)
+        };
+
+        struct queue_t {
+            uint16_t ocr1a;
+            uint16_t ocr1b;
+            uint16_t icr1;
+            uint8_t pending;                // queued_t bits.
+        };
+
+        //------------------------------------------------------------------
+        // The values waiting for the next initialise(), or Config::apply()
+        // in timer.h.
+        //------------------------------------------------------------------
+        inline queue_t &queue() {
+            static queue_t values;
+            return values;
+        }
+
+        inline void queueOCR1A(const uint16_t value) {
+            queue().ocr1a = value;
+            queue().pending |= QUEUED_OCR1A;
+        }
+
+        inline void queueOCR1B(const uint16_t value) {
+            queue().ocr1b = value;
+            queue().pending |= QUEUED_OCR1B;
+        }
+
+        inline void queueICR1(const uint16_t value) {
+            queue().icr1 = value;
+            queue().pending |= QUEUED_ICR1;
+        }
+
+        //------------------------------------------------------------------
+        // Write, and forget, anything queued. Called by initialise().
+        // ICR1 goes first as it may be TOP for the OCR1x values.
+        //------------------------------------------------------------------
+        inline void applyQueued() {
+            queue_t &values = queue();
+
+            if (values.pending & QUEUED_ICR1) {
+                writeICR1(values.icr1);
+            }
+
+            if (values.pending & QUEUED_OCR1A) {
+                writeOCR1A(values.ocr1a);
+            }
+
+            if (values.pending & QUEUED_OCR1B) {
+                writeOCR1B(values.ocr1b);
+            }
+
+            values.pending = QUEUED_NONE;
+        }
+
+
         //------------------------------------------------------------------
         // Initialise Timer 1 with a requested timer mode and clock source.
         // Setting  the clock source to anything other than CLK_DISABLED 
@@ -142,7 +293,7 @@ namespace AVRAssist {
         // force compare (A and/or B) is to be carried out, defaults to
         // neither.
         //------------------------------------------------------------------
-        void initialise(const uint8_t timerMode, 
+        inline void initialise(const uint8_t timerMode, 
                         const clockSource_t clockSource, 
                         const compareMatch_t compareMatch = OC1X_DISCONNECTED, 
                         const interrupt_t enableInterrupts = INT_NONE,
@@ -163,13 +314,18 @@ namespace AVRAssist {
             // Explicitly setting these will overwrite any previous settings
             // from the Arduino init() function, for example.
             //------------------------------------------------------------------
-            TCCR1A = (timerModes[timerMode][0]) | compareMatch;
-            TCCR1B = (timerModes[timerMode][1]) | clockSource | inputCapture;
+            TCCR1A = modeBitsA(timerMode) | compareMatch;
+            TCCR1B = modeBitsB(timerMode) | clockSource | inputCapture;
             TCCR1C = 0;
             TIMSK1 = enableInterrupts;
+
+            // Anything queued can now be written safely.
+            if (queue().pending) {
+                applyQueued();
+            }
         }
 
-        void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
+        inline void forceCompare(const forceCompare_t forcePin = FORCE_COMPARE_NONE) {
             // Are we supposed to do anything?
             if (forcePin  == FORCE_COMPARE_NONE) {
                 return;
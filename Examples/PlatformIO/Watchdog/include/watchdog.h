@@ -14,6 +14,7 @@
 #endif
 
 #include <avr/wdt.h>
+#include <avr/interrupt.h>
 
 
 namespace AVRAssist {
@@ -68,7 +69,7 @@ namespace AVRAssist {
         //------------------------------------------------------------------
         // Initialise the watchdog with a timeout and a required mode.
         //------------------------------------------------------------------
-        void initialise(const timeout_t timeout, 
+        inline void initialise(const timeout_t timeout, 
                         const mode_t mode) {
 
             //--------------------------------------------------------------